@@ -0,0 +1,644 @@
+/*
+Benchmark: headless frame cost of the UI at 1k / 10k / 100k controls.
+
+Builds flat, deep and Win3Window-like composite trees, and times each phase of a frame separately,
+reporting ns/frame and allocations/frame.  No window or GL context is needed, it draws with a SoftwareBackend.
+
+Usage: Benchmark [--csv] [--null] [--index] [--composite] [--serial] [--frames n] [--record file] [--replay file] [control counts...]
+ --csv     comma separated output, for tracking results per commit
+ --null    count draws without rasterizing anything, to measure the cost of the UI alone
+ --index   use a spatial index for hit testing the children of the main control
+ --composite  turn on UIManager::Compositing, so clean frames only composite the damaged areas
+ --serial  turn off UIManager::ParallelCanvases, to draw every canvas on the main thread
+ --frames  frames per phase (default scales with the control count)
+ --record  save the scripted input of the replay phase to a file
+ --replay  play back a recording from a file in the replay phase, instead of the scripted input
+*/
+#define OLC_PGE_APPLICATION
+
+#include "RasputinUI.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+using namespace RasputinUI;
+
+// count every allocation made by the process, so phases can report allocations/frame
+static uint64_t allocations = 0;
+
+// kept out of line, so the compiler doesn't see free called on what operator new returned and warn about a mismatch
+#if defined(__GNUC__)
+#define BENCHMARK_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define BENCHMARK_NOINLINE __declspec(noinline)
+#else
+#define BENCHMARK_NOINLINE
+#endif
+
+BENCHMARK_NOINLINE void* operator new(size_t size)
+{
+	allocations++;
+	void* p = malloc(size == 0 ? 1 : size);
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+BENCHMARK_NOINLINE void operator delete(void* p) noexcept { free(p); }
+BENCHMARK_NOINLINE void operator delete(void* p, size_t) noexcept { free(p); }
+
+static bool csv = false;
+static bool useIndex = false;
+static bool useCompositing = false;
+static bool useParallel = true;
+static const char* recordPath = NULL;
+static const char* replayPath = NULL;
+
+/* Scene: a headless UI with a tree of controls built in it */
+struct Scene
+{
+	SoftwareBackend* software = NULL;
+	RecordingBackend* recorder = NULL;
+	UIManager* ui = NULL;
+	std::vector<ControlBase*> all;
+	std::vector<TextEdit*> edits;
+	std::vector<ListControl*> lists;
+	std::vector<DragHandle*> titles;
+
+	Scene(olc::vi2d screen, bool rasterize)
+	{
+		if (rasterize)
+		{
+			software = new SoftwareBackend(screen);
+			recorder = new RecordingBackend(software);
+		}
+		else
+			recorder = new RecordingBackend(screen);
+		ui = new UIManager(recorder);
+		ui->Compositing = useCompositing;
+		ui->ParallelCanvases = useParallel;
+		ui->mainControl->Theme.Edit().Default.Background = new SolidBackground(olc::Pixel(0, 160, 160));
+	}
+
+	~Scene()
+	{
+		delete ui;
+		delete recorder;
+		delete software;
+	}
+
+	ControlBase* root() { return ui->mainControl; }
+
+	/* Collect: gather every control in the tree, for invalidating */
+	void Collect()
+	{
+		all.clear();
+		collect(root());
+	}
+
+	/* Count: the number of controls in a subtree, control included */
+	static int Count(ControlBase* control)
+	{
+		int count = 1;
+		for (auto child : control->Controls)
+			count += Count(child);
+		return count;
+	}
+
+	void InvalidateAll()
+	{
+		for (auto control : all)
+			control->Invalidate();
+	}
+
+private:
+	void collect(ControlBase* control)
+	{
+		all.push_back(control);
+		for (auto child : control->Controls)
+			collect(child);
+	}
+};
+
+static SolidBackground* panelBackground = new SolidBackground(olc::Pixel(192, 192, 192));
+static SolidBackground* titleBackground = new SolidBackground(olc::Pixel(0, 0, 128));
+static SolidBackground* editBackground = new SolidBackground(olc::WHITE);
+
+/* grid: a position for the i'th item of a given size, wrapping around the screen */
+olc::vi2d grid(int i, olc::vi2d size, olc::vi2d screen)
+{
+	int cols = std::max(1, screen.x / size.x);
+	int rows = std::max(1, (screen.y - size.y) / size.y);
+	return { (i % cols) * size.x, ((i / cols) % rows) * size.y };
+}
+
+/* BuildFlat: count small panels, all direct children of the main control */
+int BuildFlat(Scene& scene, int count)
+{
+	olc::vi2d screen = scene.root()->Size();
+	for (int i = 0; i < count; i++)
+	{
+		ControlBase* c = new ControlBase({ grid(i, { 9,9 }, screen), { 8,8 } }, scene.root());
+		c->Theme.Edit().Default.Background = panelBackground;
+		c->Theme.Edit().Default.BorderType = RUI::BorderType::Raised;
+	}
+	return count;
+}
+
+/* BuildDeep: chains of panels nested Depth levels deep */
+int BuildDeep(Scene& scene, int count)
+{
+	const int Depth = 50;
+	olc::vi2d screen = scene.root()->Size();
+	int built = 0;
+	for (int chain = 0; built < count; chain++)
+	{
+		ControlBase* parent = scene.root();
+		olc::vi2d pos = grid(chain, { 9,9 }, screen);
+		for (int d = 0; d < Depth && built < count; d++, built++)
+		{
+			ControlBase* c = new ControlBase({ pos, { 8,8 } }, parent);
+			c->Theme.Edit().Default.BorderType = (d % 2) ? RUI::BorderType::Raised : RUI::BorderType::Sunken;
+			if (d == 0)
+				c->Theme.Edit().Default.Background = panelBackground;
+			pos = { 0,0 };
+			parent = c;
+		}
+	}
+	return built;
+}
+
+/* BuildWindow: a small composite laid out like the Win3Window in Example.cpp, returns the number of controls in it */
+int BuildWindow(Scene& scene, olc::vi2d pos, int n)
+{
+	ControlBase* window = new ControlBase({ pos, { 72,60 } }, scene.root());
+	window->Theme.Edit().Default.Background = panelBackground;
+	window->Theme.Edit().Default.BorderType = RUI::BorderType::Raised;
+
+	ControlBase* titleBar = new ControlBase({ {2,2},{68,10} }, window);
+	titleBar->Theme.Edit().Default.Background = titleBackground;
+	titleBar->Theme.Edit().Default.BorderType = RUI::BorderType::Solid;
+
+	DragHandle* title = new DragHandle({ {1,1},{56,8} }, titleBar, NULL);
+	title->Theme.Edit().Default.TextAlign = { RUI::Alignment::Near, RUI::Alignment::Center };
+	title->SetText("W" + std::to_string(n));
+	title->DragControl = window;
+	scene.titles.push_back(title);
+
+	ControlBase* close = new ControlBase({ {59,1},{8,8} }, titleBar);
+	close->Theme.Edit().Default.Background = panelBackground;
+	close->Theme.Edit().Default.BorderType = RUI::BorderType::Raised;
+	close->SetText("X");
+
+	ControlBase* clientArea = new ControlBase({ {2,13},{68,45} }, window);
+	clientArea->Theme.Edit().Default.BorderType = RUI::BorderType::Sunken;
+
+	new Slider({ {2,2},{30,8} }, clientArea, 0, 255, 64, NULL);
+	new Slider({ {2,12},{30,8} }, clientArea, 0, 255, 128, NULL);
+
+	TextEdit* edit = new TextEdit({ {34,2},{32,10} }, clientArea);
+	edit->Theme.Edit().Default.Background = editBackground;
+	edit->Theme.Edit().Default.ForegroundColor = olc::BLACK;
+	edit->Theme.Edit().Default.BorderType = RUI::BorderType::Sunken;
+	edit->SetText("abc");
+	scene.edits.push_back(edit);
+
+	ControlTheme itemTheme;
+	itemTheme.Default.Background = editBackground;
+	itemTheme.Default.ForegroundColor = olc::BLACK;
+	ListControl* list = new ListControl({ {34,14},{32,28} }, clientArea, itemTheme);
+	list->ItemHeight = 8;
+	list->SetItems({ "one", "two", "three", "four", "five" });
+	scene.lists.push_back(list);
+
+	ControlBase* button = new ControlBase({ {2,30},{20,10} }, clientArea);
+	button->Theme.Edit().Default.Background = panelBackground;
+	button->Theme.Edit().Default.BorderType = RUI::BorderType::Raised;
+	button->SetText("OK");
+
+	new ResizeHandle({ {67,55},{5,5} }, window, NULL);
+	return Scene::Count(window);
+}
+
+/* BuildComposite: Win3Window-like composites until there are at least count controls */
+int BuildComposite(Scene& scene, int count)
+{
+	olc::vi2d screen = scene.root()->Size();
+	int built = 0;
+	for (int n = 0; built < count; n++)
+		built += BuildWindow(scene, grid(n, { 40,30 }, screen), n);
+	return built;
+}
+
+/* Result: the averages of one phase */
+struct Result
+{
+	double ns = 0;
+	double allocs = 0;
+	double draws = -1;
+	double uploads = -1;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+/* Measure: run setup (untimed) and body (timed) for a number of frames, and average the cost of body */
+template <class Setup, class Body>
+Result Measure(Scene& scene, int frames, bool renders, Setup setup, Body body)
+{
+	Result result;
+	double ns = 0;
+	uint64_t allocs = 0;
+	uint64_t draws = 0;
+	uint64_t uploads = 0;
+	for (int f = 0; f < frames; f++)
+	{
+		setup(f);
+		uint64_t a0 = allocations;
+		Clock::time_point t0 = Clock::now();
+		body(f);
+		Clock::time_point t1 = Clock::now();
+		allocs += allocations - a0;
+		ns += (double)std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+		draws += scene.recorder->Frame.DrawCalls;
+		uploads += scene.recorder->Frame.TextureUploads;
+	}
+	result.ns = ns / frames;
+	result.allocs = (double)allocs / frames;
+	if (renders)
+	{
+		result.draws = (double)draws / frames;
+		result.uploads = (double)uploads / frames;
+	}
+	return result;
+}
+
+void Report(const char* shape, int controls, const char* phase, Result r)
+{
+	if (csv)
+		printf("%s,%d,%s,%.0f,%.1f,%.1f,%.1f\n", shape, controls, phase, r.ns, r.allocs, r.draws, r.uploads);
+	else
+	{
+		printf("%-10s %8d  %-14s %14.0f %12.1f", shape, controls, phase, r.ns, r.allocs);
+		if (r.draws >= 0)
+			printf(" %10.1f %10.1f", r.draws, r.uploads);
+		printf("\n");
+	}
+	fflush(stdout);
+}
+
+/* random: a small deterministic generator, so every run probes the same points */
+static uint32_t seed = 12345;
+int random(int range)
+{
+	seed = seed * 1664525u + 1013904223u;
+	return (int)((seed >> 8) % (uint32_t)range);
+}
+
+olc::vi2d RandomPoint(olc::vi2d screen)
+{
+	return { random(screen.x), random(screen.y) };
+}
+
+void RunTree(const char* shape, int(*build)(Scene&, int), int count, int frames, bool rasterize)
+{
+	const olc::vi2d screen = { 640,480 };
+	Scene scene(screen, rasterize);
+	int controls = build(scene, count);
+	if (useIndex)
+		scene.root()->UseSpatialIndex();
+	scene.Collect();
+	scene.ui->Render(0.016f); // warm up, creates every canvas
+
+	Report(shape, controls, "hit-test", Measure(scene, frames, false,
+		[&](int f) {},
+		[&](int f) { scene.root()->MouseOver(RandomPoint(screen)); }));
+
+	Report(shape, controls, "render-clean", Measure(scene, frames, true,
+		[&](int f) {},
+		[&](int f) { scene.ui->Render(0.016f); }));
+
+	Report(shape, controls, "render-dirty", Measure(scene, frames, true,
+		[&](int f) { scene.InvalidateAll(); },
+		[&](int f) { scene.ui->Render(0.016f); }));
+
+	// every control flipping between two states, which replays their display lists instead of drawing them again
+	Report(shape, controls, "render-state", Measure(scene, frames, true,
+		[&](int f) {
+			for (auto control : scene.all)
+				control->Active = (f % 2) == 0;
+		},
+		[&](int f) { scene.ui->Render(0.016f); }));
+	for (auto control : scene.all)
+		control->Active = false;
+	scene.ui->Render(0.016f);
+
+	InputState input;
+	Report(shape, controls, "dispatch", Measure(scene, frames, false,
+		[&](int f) {
+			input.MousePos = RandomPoint(screen);
+			for (int i = 0; i < 3; i++)
+				input.Mouse[i] = olc::HWButton();
+			input.Mouse[0].bPressed = (f % 2) == 0;
+			input.Mouse[0].bReleased = (f % 2) == 1;
+		},
+		[&](int f) { scene.ui->HandleInput(0.016f, input); }));
+
+	if (!scene.edits.empty())
+	{
+		TextEdit* edit = scene.edits[scene.edits.size() / 2];
+		((ControlBase*)edit)->Focus();
+		Report(shape, controls, "typing", Measure(scene, frames, true,
+			[&](int f) {
+				if (edit->GetText().length() > 40)
+					edit->SetText("");
+			},
+			[&](int f) {
+				edit->TypeChar((char)('a' + (f % 26)));
+				scene.ui->Render(0.016f);
+			}));
+
+		// focused but idle, only the caret pulses
+		Report(shape, controls, "caret", Measure(scene, frames, true,
+			[&](int f) {},
+			[&](int f) { scene.ui->Render(0.016f); }));
+	}
+
+	// up to 64 top level controls sliding and fading back and forth, which shouldn't redraw any of them
+	std::vector<ControlBase*> animated;
+	for (auto control : scene.root()->Controls)
+		if (animated.size() < 64)
+			animated.push_back(control);
+	std::vector<olc::vi2d> home;
+	for (auto control : animated)
+		home.push_back(control->Position());
+	Report(shape, controls, "animate", Measure(scene, frames, true,
+		[&](int f) {
+			if (scene.ui->Animations.Active() > 0)
+				return;
+			bool out = (f / 8) % 2 == 0;
+			for (size_t i = 0; i < animated.size(); i++)
+			{
+				scene.ui->Animations.Move(animated[i], out ? home[i] + olc::vi2d(16, 8) : home[i], 0.1f);
+				scene.ui->Animations.Fade(animated[i], out ? olc::Pixel(255, 255, 255, 128) : olc::WHITE, 0.1f);
+			}
+		},
+		[&](int f) {
+			scene.ui->Animations.Tick(0.016f);
+			scene.ui->Render(0.016f);
+		}));
+	scene.ui->Animations.Tick(1.0f); // let them finish
+
+	// day and night differ for every control but TextEdits, so only the rest should redraw
+	SolidBackground dayBack(olc::Pixel(192, 192, 192)), nightBack(olc::Pixel(32, 32, 48)), editBack(olc::WHITE);
+	StyleSheet day, night;
+	day.Rule("*").Back(&dayBack).Foreground(olc::BLACK);
+	day.Rule("TextEdit").Back(&editBack).Border(RUI::BorderType::Sunken);
+	night.Rule("*").Back(&nightBack).Foreground(olc::WHITE);
+	night.Rule("TextEdit").Back(&editBack).Border(RUI::BorderType::Sunken).Foreground(olc::BLACK);
+	Report(shape, controls, "restyle", Measure(scene, frames, true,
+		[&](int f) {},
+		[&](int f) {
+			scene.ui->SetStyleSheet((f % 2) == 0 ? &day : &night);
+			scene.ui->Render(0.016f);
+		}));
+	scene.ui->SetStyleSheet(NULL);
+}
+
+void RunSetItems(int count, int frames, bool rasterize)
+{
+	Scene scene({ 640,480 }, rasterize);
+	ControlTheme itemTheme;
+	itemTheme.Default.Background = editBackground;
+	itemTheme.Default.ForegroundColor = olc::BLACK;
+	ListControl* list = new ListControl({ {10,10},{200,400} }, scene.root(), itemTheme);
+	std::vector<std::string> items;
+	for (int i = 0; i < count; i++)
+		items.push_back("Item " + std::to_string(i));
+	scene.ui->Render(0.016f);
+
+	Report("list", count, "set-items", Measure(scene, frames, false,
+		[&](int f) {},
+		[&](int f) { list->SetItems(items); }));
+
+	Report("list", count, "scroll", Measure(scene, frames, true,
+		[&](int f) {},
+		[&](int f) { list->Scroll((f % 20) < 10 ? 1 : -1); scene.ui->Render(0.016f); }));
+
+	Report("list", count, "select", Measure(scene, frames, true,
+		[&](int f) {},
+		[&](int f) { list->SetSelectedIndex(random(count)); scene.ui->Render(0.016f); }));
+
+	// typing a filter a letter at a time, then clearing it
+	const char* filters[] = { "i", "it", "ite", "item", "item 1", "item 12", "" };
+	list->WaitForIndex();
+	Report("list", count, "filter", Measure(scene, frames, true,
+		[&](int f) { if (f == 0) list->TypeAhead("item"); list->WaitForIndex(); },
+		[&](int f) { list->SetFilter(filters[f % 7]); scene.ui->Render(0.016f); }));
+
+	Report("list", count, "type-ahead", Measure(scene, frames, true,
+		[&](int f) {},
+		[&](int f) { list->TypeAhead("item " + std::to_string(random(count))); scene.ui->Render(0.016f); }));
+
+	// a live feed: a few rows appended a frame, with the list scrolled somewhere in the middle
+	list->Scroll(count / 2);
+	std::vector<std::string> feed = { "Feed a", "Feed b", "Feed c" };
+	Report("list", count, "append", Measure(scene, frames, true,
+		[&](int f) {},
+		[&](int f) {
+			list->BeginUpdate();
+			list->InsertItems(list->ItemCount(), feed);
+			list->RemoveRange(0, (int)feed.size());
+			list->EndUpdate();
+			scene.ui->Render(0.016f);
+		}));
+}
+
+void RunTextArea(int count, int frames, bool rasterize)
+{
+	Scene scene({ 640,480 }, rasterize);
+	TextArea* area = new TextArea({ {10,10},{400,320} }, scene.root());
+	area->Theme.Edit().Default.Background = editBackground;
+	area->Theme.Edit().Default.ForegroundColor = olc::BLACK;
+	std::string text;
+	for (int i = 0; i < count; i++)
+		text += "Line " + std::to_string(i) + " of the text area benchmark\n";
+	area->SetText(text);
+	((ControlBase*)area)->Focus();
+	area->SetCaret(area->LineStart(count / 2));
+	scene.ui->Render(0.016f);
+
+	// typing in the middle, a new line every 20 characters
+	Report("lines", count, "typing", Measure(scene, frames, true,
+		[&](int f) {},
+		[&](int f) {
+			area->TypeChar((f % 20) == 19 ? '\n' : (char)('a' + (f % 26)));
+			scene.ui->Render(0.016f);
+		}));
+
+	Report("lines", count, "scroll", Measure(scene, frames, true,
+		[&](int f) {},
+		[&](int f) { area->ScrollLines((f % 20) < 10 ? 3 : -3); scene.ui->Render(0.016f); }));
+
+	Report("lines", count, "jump", Measure(scene, frames, true,
+		[&](int f) {},
+		[&](int f) { area->SetCaret(area->LineStart(random(count))); scene.ui->Render(0.016f); }));
+}
+
+/* RunSprites: panels sharing one animated sprite sheet background, half of them on screen and half below it */
+void RunSprites(int count, int frames, bool rasterize)
+{
+	Scene scene({ 640,480 }, rasterize);
+	olc::vi2d screen = scene.root()->Size();
+	olc::Sprite sheet(64, 8);
+	for (int y = 0; y < sheet.height; y++)
+		for (int x = 0; x < sheet.width; x++)
+			sheet.SetPixel(x, y, olc::Pixel(x * 4, y * 32, 128));
+	AnimatedSpriteBackground spin(&sheet, { 8,8 }, 12.0f);
+	for (int i = 0; i < count; i++)
+	{
+		olc::vi2d pos = grid(i / 2, { 9,9 }, screen);
+		if (i % 2)
+			pos.y += screen.y;
+		ControlBase* c = new ControlBase({ pos, { 8,8 } }, scene.root());
+		c->Theme.Edit().Default.Background = &spin;
+	}
+	scene.ui->Render(0.016f);
+
+	// 12 fps on 60 fps frames, so the visible half should redraw every 5th frame and the rest never
+	Report("sprites", count, "animate", Measure(scene, frames, true,
+		[&](int f) {},
+		[&](int f) { scene.ui->Render(1.0f / 60.0f); }));
+}
+
+/* screenPos: where a control is on screen */
+olc::vi2d screenPos(ControlBase* control)
+{
+	olc::vi2d pos = { 0,0 };
+	for (; control != NULL; control = control->Parent)
+		pos += control->Position();
+	return pos;
+}
+
+/* Script: a session of input for a composite scene, recorded frame by frame: clicking into a TextEdit, typing, and dragging a window around */
+void Script(Scene& scene, InputRecording& recording, int frames)
+{
+	TextEdit* edit = scene.edits[scene.edits.size() / 2];
+	DragHandle* title = scene.titles[scene.titles.size() / 2];
+	olc::vi2d editPos = screenPos(edit) + edit->Size() / 2;
+	olc::vi2d titlePos = screenPos(title) + olc::vi2d(4, 4);
+
+	InputState input;
+	scene.ui->Recorder = &recording;
+	for (int f = 0; f < frames; f++)
+	{
+		int step = f % 60;
+		input.BeginFrame(0.016f);
+		if (step == 0)
+		{
+			input.Push({ InputEvent::MouseMove, 0, editPos });
+			input.Push({ InputEvent::MouseDown, 0 });
+		}
+		else if (step == 1)
+			input.Push({ InputEvent::MouseUp, 0 });
+		else if (step < 30)
+			input.Push({ InputEvent::KeyDown, olc::Key::A + (f % 26) }), input.Push({ InputEvent::KeyUp, olc::Key::A + (f % 26) });
+		else if (step == 30)
+		{
+			input.Push({ InputEvent::MouseMove, 0, titlePos });
+			input.Push({ InputEvent::MouseDown, 0 });
+		}
+		else if (step < 59)
+		{
+			// there and back again, so the window ends where it started
+			titlePos += step < 45 ? olc::vi2d(2, 1) : olc::vi2d(-2, -1);
+			input.Push({ InputEvent::MouseMove, 0, titlePos });
+		}
+		else
+			input.Push({ InputEvent::MouseUp, 0 });
+		scene.ui->Update(0.016f, input);
+	}
+	scene.ui->Recorder = NULL;
+}
+
+/* RunReplay: play back a recording of input, a frame of it per frame, in a fresh composite scene */
+void RunReplay(int count, int frames, bool rasterize)
+{
+	InputRecording recording;
+	if (replayPath != NULL)
+	{
+		if (!recording.Load(replayPath))
+		{
+			fprintf(stderr, "couldn't load recording %s\n", replayPath);
+			return;
+		}
+	}
+	else
+	{
+		Scene scripted({ 640,480 }, false);
+		BuildComposite(scripted, count);
+		scripted.ui->Render(0.016f);
+		Script(scripted, recording, frames);
+		if (recordPath != NULL && !recording.Save(recordPath))
+			fprintf(stderr, "couldn't save recording %s\n", recordPath);
+	}
+
+	Scene scene({ 640,480 }, rasterize);
+	int controls = BuildComposite(scene, count);
+	scene.ui->Render(0.016f);
+	InputState input;
+	float elapsed = 0;
+	Report("composite", controls, "replay", Measure(scene, (int)recording.Frames(), true,
+		[&](int f) {},
+		[&](int f) {
+			if (recording.Next(elapsed, input))
+				scene.ui->Update(elapsed, input);
+		}));
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<int> counts;
+	int frames = 0;
+	bool rasterize = true;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--csv") == 0)
+			csv = true;
+		else if (strcmp(argv[i], "--null") == 0)
+			rasterize = false;
+		else if (strcmp(argv[i], "--index") == 0)
+			useIndex = true;
+		else if (strcmp(argv[i], "--composite") == 0)
+			useCompositing = true;
+		else if (strcmp(argv[i], "--serial") == 0)
+			useParallel = false;
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			frames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+			recordPath = argv[++i];
+		else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+			replayPath = argv[++i];
+		else
+			counts.push_back(atoi(argv[i]));
+	}
+	if (counts.empty())
+		counts = { 1000, 10000, 100000 };
+
+	if (csv)
+		printf("shape,controls,phase,ns_per_frame,allocs_per_frame,draws_per_frame,uploads_per_frame\n");
+	else
+		printf("%-10s %8s  %-14s %14s %12s %10s %10s\n", "shape", "controls", "phase", "ns/frame", "allocs/frame", "draws", "uploads");
+
+	for (int count : counts)
+	{
+		int f = frames > 0 ? frames : std::max(3, std::min(100, 500000 / count));
+		RunTree("flat", BuildFlat, count, f, rasterize);
+		RunTree("deep", BuildDeep, count, f, rasterize);
+		RunTree("composite", BuildComposite, count, f, rasterize);
+		RunSetItems(count, f, rasterize);
+		RunTextArea(count, f, rasterize);
+		RunSprites(count, f, rasterize);
+		RunReplay(count, std::max(f, 60), rasterize);
+	}
+	return 0;
+}
@@ -22,19 +22,19 @@ public:
 	Win3Window(Rect location, ControlBase* parent, olc::PixelGameEngine* pge)
 		:ControlBase(location, parent)
 	{
-		Theme.Default.Background = new SolidBackground(olc::Pixel(r, g, b));
-		Theme.Default.BorderType = RUI::BorderType::Raised;
+		Theme.Edit().Default.Background = new SolidBackground(olc::Pixel(r, g, b));
+		Theme.Edit().Default.BorderType = RUI::BorderType::Raised;
 
 		clientArea = new ControlBase({ {3,24},{Location.Size.x - 6,Location.Size.y - 27} }, this);
-		clientArea->Theme.Default.BorderType = RUI::BorderType::Sunken;
+		clientArea->Theme.Edit().Default.BorderType = RUI::BorderType::Sunken;
 
 		titleBar = new ControlBase({ {3,3},{Location.Size.x - 6,20} }, this);
-		titleBar->Theme.Default.Padding = { 3,3,3,3 };
-		titleBar->Theme.Default.BorderType = RUI::BorderType::Solid;
-		titleBar->Theme.Default.Background = new SolidBackground(olc::Pixel(0, 0, 128));
+		titleBar->Theme.Edit().Default.Padding = { 3,3,3,3 };
+		titleBar->Theme.Edit().Default.BorderType = RUI::BorderType::Solid;
+		titleBar->Theme.Edit().Default.Background = new SolidBackground(olc::Pixel(0, 0, 128));
 				
 		windowTitle = new DragHandle({ {3,3},{Location.Size.x - 32,14} }, titleBar, pge);
-		windowTitle->Theme.Default.TextAlign = { RUI::Alignment::Near, RUI::Alignment::Center };
+		windowTitle->Theme.Edit().Default.TextAlign = { RUI::Alignment::Near, RUI::Alignment::Center };
 		windowTitle->SetText("Test Window");
 
 		CountDraggo = new DragHandle({ {3,3},{Location.Size.x - 32,14} }, titleBar, pge);
@@ -42,12 +42,12 @@ public:
 
 
 		closeButton = new ControlBase({ { Location.Size.x - 24,3 }, { 14,14 } }, titleBar);
-		closeButton->Theme.Default.Background = new SolidBackground(olc::Pixel(192,192,192));
-		closeButton->Theme.Default.ForegroundColor = olc::Pixel(32,32,32);
-		closeButton->Theme.Hover.empty = false;
-		closeButton->Theme.Hover.Background = new SolidBackground(olc::GREY);
-		closeButton->Theme.Hover.ForegroundColor = olc::BLACK;
-		closeButton->Theme.Default.BorderType = RUI::BorderType::Raised;
+		closeButton->Theme.Edit().Default.Background = new SolidBackground(olc::Pixel(192,192,192));
+		closeButton->Theme.Edit().Default.ForegroundColor = olc::Pixel(32,32,32);
+		closeButton->Theme.Edit().Hover.empty = false;
+		closeButton->Theme.Edit().Hover.Background = new SolidBackground(olc::GREY);
+		closeButton->Theme.Edit().Hover.ForegroundColor = olc::BLACK;
+		closeButton->Theme.Edit().Default.BorderType = RUI::BorderType::Raised;
 		closeButton->SetText("X");
 
 		closeButton->OnClick.Subscribe([&](ControlBase* sender, int mButton) {Visible = false; });
@@ -66,31 +66,31 @@ public:
 
 		rslider->OnValue.Subscribe([&](ControlBase* sender, int val) {
 			r = val;
-			((SolidBackground*)Theme.Default.Background)->Color = olc::Pixel(r, g, b, a);
+			((SolidBackground*)Theme->Default.Background)->Color = olc::Pixel(r, g, b, a);
 			Invalidate();
 		});
 		gslider->OnValue.Subscribe([&](ControlBase* sender, int val) {
 			g = val;
-			((SolidBackground*)Theme.Default.Background)->Color = olc::Pixel(r, g, b, a);
+			((SolidBackground*)Theme->Default.Background)->Color = olc::Pixel(r, g, b, a);
 			Invalidate();
 		});
 		bslider->OnValue.Subscribe([&](ControlBase* sender, int val) {
 			b = val;
-			((SolidBackground*)Theme.Default.Background)->Color = olc::Pixel(r, g, b, a);
+			((SolidBackground*)Theme->Default.Background)->Color = olc::Pixel(r, g, b, a);
 			Invalidate();
 		});
 		aslider->OnValue.Subscribe([&](ControlBase* sender, int val) {
 			a = val;
-			((SolidBackground*)Theme.Default.Background)->Color = olc::Pixel(r, g, b,a);
+			((SolidBackground*)Theme->Default.Background)->Color = olc::Pixel(r, g, b,a);
 			Invalidate();
 		});
 
 		testEdit = new TextEdit({ {130,10},{150,20} }, clientArea);
-		testEdit->Theme.Default.Background = new SolidBackground(olc::WHITE);
-		testEdit->Theme.Default.ForegroundColor = olc::BLACK;
-		testEdit->Theme.Default.Padding = { 2,2,2,2 };
-		testEdit->Theme.Default.TextAlign = { RUI::Alignment::Near,RUI::Alignment::Center };
-		testEdit->Theme.Default.BorderType = RUI::BorderType::Sunken;
+		testEdit->Theme.Edit().Default.Background = new SolidBackground(olc::WHITE);
+		testEdit->Theme.Edit().Default.ForegroundColor = olc::BLACK;
+		testEdit->Theme.Edit().Default.Padding = { 2,2,2,2 };
+		testEdit->Theme.Edit().Default.TextAlign = { RUI::Alignment::Near,RUI::Alignment::Center };
+		testEdit->Theme.Edit().Default.BorderType = RUI::BorderType::Sunken;
 		testEdit->SetText("asdf");
 
 		
@@ -105,18 +105,18 @@ public:
 		ct.Active.ForegroundColor = olc::WHITE;
 
 		listControl = new ListControl({ {130,40},{150,100} }, clientArea, ct);
-		listControl->Theme.Default.BorderType = RUI::BorderType::Sunken;
-		listControl->Theme.Default.Padding = { 2,2,2,2 };
+		listControl->Theme.Edit().Default.BorderType = RUI::BorderType::Sunken;
+		listControl->Theme.Edit().Default.Padding = { 2,2,2,2 };
 
 		std::vector<std::string> list_items = { "Some Item","Some Other Item", "Yet Another Item", "Extra Item", "Bonus Item" };
 		listControl->SetItems(list_items);
 
 		testButton = new ControlBase({ {10,120},{50,20} }, clientArea);
-		testButton->Theme.Default.Background = new SolidBackground(olc::DARK_GREY);
-		testButton->Theme.Default.BorderType = RUI::BorderType::Raised;
-		testButton->Theme.Default.TextAlign = { RUI::Alignment::Center,RUI::Alignment::Center };
-		testButton->Theme.Active = testButton->Theme.Default.DeepCopy();
-		testButton->Theme.Active.BorderType = RUI::BorderType::Sunken;
+		testButton->Theme.Edit().Default.Background = new SolidBackground(olc::DARK_GREY);
+		testButton->Theme.Edit().Default.BorderType = RUI::BorderType::Raised;
+		testButton->Theme.Edit().Default.TextAlign = { RUI::Alignment::Center,RUI::Alignment::Center };
+		testButton->Theme.Edit().Active = testButton->Theme->Default.DeepCopy();
+		testButton->Theme.Edit().Active.BorderType = RUI::BorderType::Sunken;
 
 		testButton->OnMouseDown.Subscribe([&](ControlBase* sender, int mButton) 
 		{
@@ -155,15 +155,26 @@ public:
 	bool OnUserCreate() override
 	{
 		uiManager = new RasputinUI::UIManager();
+		uiManager->DeferEvents = true; // resizing a window lays it out once a frame, not once per step
 		olc::Pixel gridcolor = olc::RED;
 		gridcolor.a = 40;
-		uiManager->mainControl->Theme.Default.Background = new SolidBackground(olc::Pixel(0,160,160));
+		uiManager->mainControl->Theme.Edit().Default.Background = new SolidBackground(olc::Pixel(0,160,160));
 
 		Win3Window* win1 = new Win3Window({ {10,10},{300,200} }, uiManager->mainControl, this);
 		Win3Window* win2 = new Win3Window({ {320,10},{300,200} }, uiManager->mainControl, this);
 		Win3Window* win3 = new Win3Window({ {10,220},{300,200} }, uiManager->mainControl, this);
 		Win3Window* win4 = new Win3Window({ {320,220},{300,200} }, uiManager->mainControl, this);
 
+		// slide the windows in from the left, one after another, fading in as they go
+		Timeline intro(uiManager->Animations);
+		for (Win3Window* win : { win1, win2, win3, win4 })
+		{
+			olc::vi2d home = win->Position();
+			win->SetPosition({ -300, home.y });
+			win->SetTint(olc::Pixel(255, 255, 255, 0));
+			intro.Move(win, home, 0.4f, Ease::OutBack).Fade(win, olc::WHITE, 0.4f).Then(-0.25f);
+		}
+
 		Clear(olc::BLACK);
 		return true;
 	}
@@ -13,62 +13,216 @@ Requires olcPixelGameEngine.h
 #ifndef RASPUTIN_UI_DEF
 #define RASPUTIN_UI_DEF
 #include "olcPixelGameEngine.h"
+#include <unordered_map>
+#include <memory>
+#include <deque>
+#include <new>
+#include <cstddef>
+#include <climits>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <array>
+#include <cmath>
+
+// SIMD blend kernels, picked at compile time.  Define RASPUTINUI_NO_SIMD to use the scalar ones.
+#ifndef RASPUTINUI_NO_SIMD
+#if defined(__AVX2__)
+#define RASPUTINUI_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RASPUTINUI_SSE2
+#endif
+#endif
+#if defined(RASPUTINUI_AVX2)
+#include <immintrin.h>
+#elif defined(RASPUTINUI_SSE2)
+#include <emmintrin.h>
+#endif
 
 namespace RasputinUI
 {
 	// Forward declares to handle dependencies
 	class ControlBase;
 	class UIManager;
+	class RenderBackend;
 
-	/* Class: EventHandler   Handles subscription and dispatch of events that take only the initiating control as a parameter */
-	class EventHandler
+	/* EventToken: identifies one subscription to an event, to Unsubscribe it with.  A default token is subscribed to nothing. */
+	struct EventToken
+	{
+		uint32_t Slot = 0;
+		uint32_t Generation = 0;
+
+		bool Valid() const { return Generation != 0; }
+	};
+
+	/* Class: EventDelegate   Handles subscription and dispatch of events, called with Args.
+	   Callables up to InlineSize bytes are stored in place, and nothing is allocated at all until something subscribes.
+	   Handlers may subscribe and unsubscribe (themselves included) while the event is being invoked, new ones are called from the next Invoke. */
+	template <class... Args>
+	class EventDelegate
 	{
-	private:
-		std::list<std::function<void(ControlBase*)>> subscribers;
 	public:
-		void Subscribe(std::function<void(ControlBase*)> callback)
+		static const size_t InlineSize = 4 * sizeof(void*);
+
+		EventDelegate() {}
+		EventDelegate(const EventDelegate&) = delete;
+		EventDelegate& operator=(const EventDelegate&) = delete;
+		~EventDelegate() { delete slots; }
+
+		/* Subscribe: call callback whenever the event is invoked, until the returned token is unsubscribed */
+		template <class F>
+		EventToken Subscribe(F&& callback)
 		{
-			subscribers.push_back(callback);
+			typedef typename std::decay<F>::type Callable;
+			if (slots == NULL)
+				slots = new SlotList();
+
+			uint32_t index;
+			if (!slots->free.empty() && slots->invoking == 0) // a reused slot below an Invoke's count would be called by it
+			{
+				index = slots->free.back();
+				slots->free.pop_back();
+			}
+			else
+			{
+				index = (uint32_t)slots->items.size();
+				slots->items.emplace_back();
+			}
+
+			Slot& slot = slots->items[index];
+			if (sizeof(Callable) <= InlineSize && alignof(Callable) <= alignof(std::max_align_t))
+			{
+				slot.target = new (slot.storage) Callable(std::forward<F>(callback));
+				slot.destroy = [](void* target) { ((Callable*)target)->~Callable(); };
+			}
+			else
+			{
+				slot.target = new Callable(std::forward<F>(callback));
+				slot.destroy = [](void* target) { delete (Callable*)target; };
+			}
+			slot.call = [](void* target, Args... args) { (*(Callable*)target)(args...); };
+
+			EventToken token;
+			token.Slot = index;
+			token.Generation = slot.generation;
+			return token;
 		}
 
-		void Invoke(ControlBase* sender)
+		/* Unsubscribe: stop calling the subscription the token came from, and reset the token.  Stale and default tokens are ignored. */
+		void Unsubscribe(EventToken& token)
 		{
-			for (auto sub : subscribers)
+			if (slots != NULL && token.Valid() && token.Slot < slots->items.size())
 			{
-				try
+				Slot& slot = slots->items[token.Slot];
+				if (slot.generation == token.Generation && slot.call != NULL)
 				{
-					sub(sender);
+					slot.call = NULL;
+					if (++slot.generation == 0)
+						slot.generation = 1;
+					if (slots->invoking > 0)
+						slots->dying.push_back(token.Slot); // it may be the handler running right now
+					else
+						release(token.Slot);
 				}
-				catch (...) {}  // this sucks, as it will hide that an event isnt working to the consumer, but it also keeps one event handler from breaking the world
 			}
+			token = EventToken();
 		}
-	};
 
-	/* Class: EventHandler   Handles subscription and dispatch of events that take the initiating control and one additional parameter.
-	   defined by template class T */
-	template <class T>
-	class EventHandler1Param
-	{
-	private:
-		std::list<std::function<void(ControlBase*, T)>> subscribers;
-	public:
-		void Subscribe(std::function<void(ControlBase*, T)> callback)
+		/* Clear: unsubscribe everything */
+		void Clear()
 		{
-			subscribers.push_back(callback);
+			if (slots == NULL)
+				return;
+			for (uint32_t i = 0; i < slots->items.size(); i++)
+			{
+				EventToken token;
+				token.Slot = i;
+				token.Generation = slots->items[i].generation;
+				Unsubscribe(token);
+			}
+		}
+
+		/* Empty: true if nothing is subscribed */
+		bool Empty() const
+		{
+			return slots == NULL || slots->items.size() == slots->free.size() + slots->dying.size();
 		}
-		void Invoke(ControlBase* sender, T val = NULL)
+
+		void Invoke(Args... args)
 		{
-			for (auto sub : subscribers)
+			if (slots == NULL)
+				return;
+			SlotList* list = slots;
+			list->invoking++;
+			size_t count = list->items.size();
+			for (size_t i = 0; i < count; i++)
 			{
+				Slot& slot = list->items[i];
+				if (slot.call == NULL)
+					continue;
 				try
 				{
-					sub(sender, val);
+					slot.call(slot.target, args...);
 				}
-				catch (...) {}
+				catch (...) {}  // this sucks, as it will hide that an event isnt working to the consumer, but it also keeps one event handler from breaking the world
+			}
+			if (--list->invoking == 0)
+			{
+				for (auto index : list->dying)
+					release(index);
+				list->dying.clear();
+			}
+		}
+
+	private:
+		/* Slot: one subscription, the callable in storage if it fits, otherwise on the heap */
+		struct Slot
+		{
+			alignas(std::max_align_t) unsigned char storage[InlineSize];
+			void* target = NULL;
+			void (*call)(void*, Args...) = NULL;
+			void (*destroy)(void*) = NULL;
+			uint32_t generation = 1;
+
+			~Slot()
+			{
+				if (destroy != NULL)
+					destroy(target);
 			}
+		};
+
+		/* SlotList: the subscriptions, in a deque so a slot never moves while it is being called */
+		struct SlotList
+		{
+			std::deque<Slot> items;
+			std::vector<uint32_t> free;
+			std::vector<uint32_t> dying;
+			int invoking = 0;
+		};
+
+		SlotList* slots = NULL;
+
+		void release(uint32_t index)
+		{
+			Slot& slot = slots->items[index];
+			slot.destroy(slot.target);
+			slot.destroy = NULL;
+			slot.target = NULL;
+			slots->free.push_back(index);
 		}
 	};
 
+	/* EventHandler: events that take only the initiating control as a parameter */
+	typedef EventDelegate<ControlBase*> EventHandler;
+
+	/* EventHandler1Param: events that take the initiating control and one additional parameter, defined by T */
+	template <class T>
+	using EventHandler1Param = EventDelegate<ControlBase*, T>;
+
 	/* Rectangle class, not strictly needed, but makes some calculations more convenient*/
 	struct Rect
 	{
@@ -87,7 +241,29 @@ namespace RasputinUI
 
 		bool Intersects(Rect otherRect)
 		{
-			return Contains(otherRect.Position) || Contains({ otherRect.right(),otherRect.Position.y }) || Contains({ otherRect.Position.x,otherRect.bottom() }) || Contains({ otherRect.right(),otherRect.bottom() });
+			return otherRect.Position.x <= right() && Position.x <= otherRect.right() && otherRect.Position.y <= bottom() && Position.y <= otherRect.bottom();
+		}
+
+		/* Intersection: the part of this rectangle that is also in otherRect, empty if they dont overlap */
+		Rect Intersection(Rect otherRect)
+		{
+			int x1 = std::max(Position.x, otherRect.Position.x);
+			int y1 = std::max(Position.y, otherRect.Position.y);
+			int x2 = std::min(right(), otherRect.right());
+			int y2 = std::min(bottom(), otherRect.bottom());
+			if (x2 <= x1 || y2 <= y1)
+				return Rect();
+			return Rect({ x1,y1 }, { x2 - x1,y2 - y1 });
+		}
+
+		/* Union: the smallest rectangle containing both */
+		Rect Union(Rect otherRect)
+		{
+			int x1 = std::min(Position.x, otherRect.Position.x);
+			int y1 = std::min(Position.y, otherRect.Position.y);
+			int x2 = std::max(right(), otherRect.right());
+			int y2 = std::max(bottom(), otherRect.bottom());
+			return Rect({ x1,y1 }, { x2 - x1,y2 - y1 });
 		}
 
 		int32_t right()
@@ -124,8 +300,8 @@ namespace RasputinUI
 		int bottom;
 		int left;
 
-		int vert() { return top + bottom; }
-		int horiz() { return left + right; }
+		int vert() const { return top + bottom; }
+		int horiz() const { return left + right; }
 	};
 
 	class RUI
@@ -148,11 +324,400 @@ namespace RasputinUI
 		RUI::Alignment Vertical;
 	};
 
+	/* DamageTracker: the areas of the screen that need compositing again, reported by controls as they change.
+		Overlapping areas are merged, and past MaxRects everything is merged into one. */
+	class DamageTracker
+	{
+	public:
+		/* Enabled: only collect damage while something is going to use it */
+		bool Enabled = false;
+		std::vector<Rect> Rects;
+		size_t MaxRects = 16;
+
+		void Add(Rect area)
+		{
+			if (!Enabled || area.Size.x <= 0 || area.Size.y <= 0)
+				return;
+			bool merged = true;
+			while (merged) // a merged area can now overlap others
+			{
+				merged = false;
+				for (size_t i = 0; i < Rects.size(); i++)
+				{
+					if (Rects[i].Intersects(area))
+					{
+						area = Rects[i].Union(area);
+						Rects.erase(Rects.begin() + i);
+						merged = true;
+						break;
+					}
+				}
+			}
+			Rects.push_back(area);
+			if (Rects.size() > MaxRects)
+			{
+				Rect all = Rects[0];
+				for (auto& r : Rects)
+					all = all.Union(r);
+				Rects.clear();
+				Rects.push_back(all);
+			}
+		}
+
+		void Clear() { Rects.clear(); }
+	};
+
+	/* WorkerPool: threads that share out the items of a job, each working through its own share of them and then stealing from the others'.
+		The calling thread works too, so Run returns once every item is done. */
+	class WorkerPool
+	{
+	public:
+		/* Constructor: threads 0 uses one fewer thread than the hardware has, as the calling thread is one */
+		WorkerPool(unsigned threads = 0)
+		{
+			if (threads == 0)
+				threads = std::max(1u, std::thread::hardware_concurrency()) - 1;
+			shares.reset(new Share[threads + 1]);
+			for (unsigned i = 0; i < threads; i++)
+				this->threads.emplace_back([this, i]() { loop(i + 1); });
+		}
+
+		WorkerPool(const WorkerPool&) = delete;
+		WorkerPool& operator=(const WorkerPool&) = delete;
+
+		~WorkerPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			wake.notify_all();
+			for (auto& thread : threads)
+				thread.join();
+		}
+
+		/* Workers: the number of threads Run works on, the calling one included */
+		size_t Workers() const { return threads.size() + 1; }
+
+		/* Run: call work(item, worker) for every item from 0 to count, worker being 0 for the calling thread and 1 on for the pool's */
+		template <class F>
+		void Run(size_t count, F&& work)
+		{
+			if (count == 0)
+				return;
+			typedef typename std::remove_reference<F>::type Callable;
+			size_t workers = Workers();
+			for (size_t w = 0; w < workers; w++)
+			{
+				shares[w].Next = count * w / workers;
+				shares[w].End = count * (w + 1) / workers;
+			}
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				job = &work;
+				call = [](void* target, size_t item, size_t worker) { (*(Callable*)target)(item, worker); };
+				running = threads.size();
+				generation++;
+			}
+			wake.notify_all();
+			steal(0);
+			std::unique_lock<std::mutex> lock(mutex);
+			done.wait(lock, [this]() { return running == 0; });
+			job = NULL;
+		}
+
+	private:
+		/* Share: the items a worker has left, taken from the front by it and by thieves alike */
+		struct alignas(64) Share
+		{
+			std::atomic<size_t> Next{ 0 };
+			size_t End = 0;
+		};
+
+		std::vector<std::thread> threads;
+		std::unique_ptr<Share[]> shares;
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::condition_variable done;
+		void* job = NULL;
+		void (*call)(void*, size_t, size_t) = NULL;
+		uint64_t generation = 0;
+		size_t running = 0;
+		bool stopping = false;
+
+		/* steal: work through our own share, then the others' */
+		void steal(size_t worker)
+		{
+			size_t workers = Workers();
+			for (size_t v = 0; v < workers; v++)
+			{
+				Share& share = shares[(worker + v) % workers];
+				for (size_t item = share.Next.fetch_add(1); item < share.End; item = share.Next.fetch_add(1))
+					call(job, item, worker);
+			}
+		}
+
+		void loop(size_t worker)
+		{
+			uint64_t seen = 0;
+			for (;;)
+			{
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					wake.wait(lock, [&]() { return stopping || generation != seen; });
+					if (stopping)
+						return;
+					seen = generation;
+				}
+				steal(worker);
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					running--;
+				}
+				done.notify_one();
+			}
+		}
+	};
+
+	/* TextLayout: a string measured and laid out in the 8x8 olcPixelGameEngine font, unscaled, so drawing it again needs no layout.
+		Layouts are shared (see TextLayoutCache), and a DisplayList keeps the ones it draws alive. */
+	struct TextLayout : std::enable_shared_from_this<TextLayout>
+	{
+		/* Glyph: a character that puts pixels down, and where */
+		struct Glyph
+		{
+			olc::vi2d Pos;
+			uint32_t Index; // into Text
+			char C;
+		};
+
+		std::string Text;
+		/* Size: the same as PixelGameEngine::GetTextSize */
+		olc::vi2d Size = { 0,0 };
+		/* CharPos: where each character of Text starts, plus one past the end */
+		std::vector<olc::vi2d> CharPos;
+		std::vector<Glyph> Glyphs;
+
+		/* TabSize: the number of spaces a tab takes up, as in olcPixelGameEngine */
+		static const int TabSize = 4;
+
+		TextLayout(const std::string& text)
+		{
+			Text = text;
+			CharPos.reserve(text.length() + 1);
+			olc::vi2d pos = { 0,0 };
+			olc::vi2d chars = { 0,1 }; // in characters, like GetTextSize counts
+			int column = 0;
+			for (uint32_t i = 0; i < text.length(); i++)
+			{
+				char c = text[i];
+				CharPos.push_back(pos);
+				if (c == '\n')
+				{
+					pos = { 0, pos.y + 8 };
+					column = 0;
+					chars.y++;
+				}
+				else if (c == '\t')
+				{
+					pos.x += 8 * TabSize;
+					column += TabSize;
+				}
+				else
+				{
+					if ((unsigned char)c >= 32 && (unsigned char)c < 128)
+						Glyphs.push_back({ pos, i, c });
+					pos.x += 8;
+					column++;
+				}
+				chars.x = std::max(chars.x, column);
+			}
+			CharPos.push_back(pos);
+			Size = { chars.x * 8, chars.y * 8 };
+		}
+
+		/* Advance: how far a character moves the rest of a line along, unscaled */
+		static int Advance(char c)
+		{
+			return c == '\t' ? 8 * TabSize : (c == '\n' ? 0 : 8);
+		}
+
+		/* Width: the width of a single line from character first to the end, unscaled */
+		int Width(size_t first) const
+		{
+			return CharPos.back().x - CharPos[std::min(first, CharPos.size() - 1)].x;
+		}
+	};
+
+	/* TextLayoutCache: layouts by string, so the same label, list item or button text is only laid out once.
+		Anyone holding a layout keeps it, even if the cache lets go of it. */
+	class TextLayoutCache
+	{
+	private:
+		std::unordered_map<std::string, std::shared_ptr<const TextLayout>> layouts;
+	public:
+		/* MaxEntries: the cache is emptied when it reaches this many strings */
+		size_t MaxEntries = 4096;
+
+		std::shared_ptr<const TextLayout> Get(const std::string& text)
+		{
+			auto it = layouts.find(text);
+			if (it != layouts.end())
+				return it->second;
+			if (layouts.size() >= MaxEntries)
+				layouts.clear();
+			auto layout = std::make_shared<const TextLayout>(text);
+			layouts[text] = layout;
+			return layout;
+		}
+
+		void Clear() { layouts.clear(); }
+	};
+
+	class StyleSheet;
+	class Animator;
+	class DisplayList;
+	class DisplayListRecorder;
+
+	/* EventQueue: controls with events waiting, while events are deferred.  Each control is in it at most once, with its events coalesced. */
+	struct EventQueue
+	{
+		/* Deferred: queue OnMove, OnResize and OnValue until the next flush instead of raising them straight away */
+		bool Deferred = false;
+		std::vector<ControlBase*> Pending;
+		/* Flushing: the controls being flushed right now, new events go to Pending for the next round */
+		std::vector<ControlBase*> Flushing;
+
+		/* Remove: forget a control that is going away */
+		void Remove(ControlBase* control)
+		{
+			for (auto& pending : Pending)
+				if (pending == control)
+					pending = NULL;
+			for (auto& pending : Flushing)
+				if (pending == control)
+					pending = NULL;
+		}
+	};
+
+	/* UIContext: state shared by every control in a UIManager's tree.  Controls pick it up from their parent when created. */
+	struct UIContext
+	{
+		DamageTracker Damage;
+		EventQueue Events;
+		/* Styles: the StyleSheet controls take their theme from, if any */
+		StyleSheet* Styles = NULL;
+		/* Animations: the Animator of the UIManager, so animations of a control stop when it is deleted */
+		Animator* Animations = NULL;
+		/* Frame: counts the frames drawn, so shared animated backgrounds only tick once a frame */
+		uint64_t Frame = 0;
+		/* Lists: records the drawing of controls into their display lists, NULL to draw without recording */
+		DisplayListRecorder* Lists = NULL;
+		/* StaleCanvases: roughly how many canvases need drawing again since the last frame was drawn */
+		size_t StaleCanvases = 0;
+		/* Raised: controls with children raised since their Controls were last sorted, for the UIManager to sort at a safe point */
+		std::vector<ControlBase*> Raised;
+	};
+
+	/* Canvas: the cached pixels of a control.  It is created, drawn into and uploaded through a RenderBackend.
+	   Decal is only used by backends that put canvases on the GPU, and is NULL otherwise. */
+	struct Canvas
+	{
+		/* Owner: the backend that created this canvas, and is responsible for freeing it */
+		RenderBackend* Owner = NULL;
+		olc::Sprite* Sprite = NULL;
+		olc::Decal* Decal = NULL;
+		olc::vi2d Size = { 0,0 };
+		/* Page / Offset: for a canvas packed into an atlas, the page it is on and where its pixels are in Sprite.  Page is -1 if it has Sprite to itself. */
+		int Page = -1;
+		olc::vi2d Offset = { 0,0 };
+		/* Redraws / RedrawFrame: how many times running the canvas was redrawn soon after the time before, and the frame it last was, for backends that treat canvases redrawn often differently */
+		int Redraws = 0;
+		uint64_t RedrawFrame = 0;
+	};
+
+	/* RenderBackend: everything the UI draws goes through here, so the UI can run on top of olcPixelGameEngine, or without a window at all.
+		Drawing calls (Clear through DrawPartialSprite) go to the canvas set by BeginCanvas, in canvas coordinates.
+		DrawCanvas and DrawPartialCanvas composite a finished canvas onto the screen. */
+	class RenderBackend
+	{
+	public:
+		virtual ~RenderBackend() {}
+
+		/* ScreenSize: the size of the surface the UI is composited onto */
+		virtual olc::vi2d ScreenSize() = 0;
+
+		/* BeginFrame / EndFrame: called by the UIManager around each frame it draws */
+		virtual void BeginFrame() {}
+		virtual void EndFrame() {}
+
+		/* CreateCanvas: (re)create the storage of a canvas at the given size, its contents are undefined until drawn */
+		virtual void CreateCanvas(Canvas& canvas, olc::vi2d size) = 0;
+		/* FreeCanvas: release the storage of a canvas created by this backend */
+		virtual void FreeCanvas(Canvas& canvas) = 0;
+		/* BeginCanvas: send all drawing calls to this canvas until EndCanvas is called */
+		virtual void BeginCanvas(Canvas& canvas) = 0;
+		/* EndCanvas: finish drawing to the canvas, uploading it if the backend keeps textures */
+		virtual void EndCanvas(Canvas& canvas) = 0;
+
+		virtual void Clear(olc::Pixel p) = 0;
+		virtual void FillRect(olc::vi2d pos, olc::vi2d size, olc::Pixel p) = 0;
+		virtual void DrawRect(olc::vi2d pos, olc::vi2d size, olc::Pixel p) = 0;
+		virtual void DrawString(olc::vi2d pos, const std::string& text, olc::Pixel p, uint32_t scale) = 0;
+		virtual olc::vi2d GetTextSize(const std::string& text) = 0;
+		/* DrawTextLayout: draw laid out text, from character first on, as if the text started there */
+		virtual void DrawTextLayout(olc::vi2d pos, const TextLayout& layout, olc::Pixel p, uint32_t scale, size_t first = 0) = 0;
+
+		/* LayoutText: the layout of a string in this backend's font, cached */
+		std::shared_ptr<const TextLayout> LayoutText(const std::string& text) { return textLayouts.Get(text); }
+		virtual void DrawSprite(olc::vi2d pos, olc::Sprite* sprite, uint32_t scale) = 0;
+		virtual void DrawPartialSprite(olc::vi2d pos, olc::Sprite* sprite, olc::vi2d sourcePos, olc::vi2d size, uint32_t scale) = 0;
+		/* DrawBevel: a border of the given type around area, drawn with FillRect and DrawRect unless a backend does better */
+		virtual void DrawBevel(RUI::BorderType borderType, Rect area);
+
+		/* DrawCanvas: composite a whole canvas onto the screen, its colors multiplied by tint */
+		virtual void DrawCanvas(Canvas& canvas, olc::vf2d pos, olc::Pixel tint = olc::WHITE) = 0;
+		/* DrawPartialCanvas: composite part of a canvas onto the screen, its colors multiplied by tint */
+		virtual void DrawPartialCanvas(Canvas& canvas, olc::vf2d pos, olc::vf2d sourcePos, olc::vf2d sourceSize, olc::Pixel tint = olc::WHITE) = 0;
+		/* DrawQuad: composite a rectangle of one color onto the screen, blended like a canvas.  For overlays, drawn without a canvas of their own */
+		virtual void DrawQuad(olc::vi2d pos, olc::vi2d size, olc::Pixel p) = 0;
+
+		/* BeginComposite: clear an area of target and send DrawCanvas and DrawPartialCanvas there instead of the screen, clipped to the area.
+		   It can be called for several areas in a row, then EndComposite once when they are all done. */
+		virtual void BeginComposite(Canvas& target, Rect area) = 0;
+		/* EndComposite: go back to drawing canvases on the screen, uploading target if the backend keeps textures */
+		virtual void EndComposite(Canvas& target) = 0;
+
+		/* PrepareRasterize: get ready for RasterizeCanvas to be called from up to workers threads at once, on the main thread.
+		   False if the backend can only draw canvases through BeginCanvas and EndCanvas, on one thread. */
+		virtual bool PrepareRasterize(size_t workers) { return false; }
+		/* RasterizeCanvas: clear a canvas and draw a display list into it, on a worker thread, without touching the engine or anything shared.
+		   Different canvases are drawn at once, each by one worker at a time.  Nothing is uploaded until FinishCanvas. */
+		virtual void RasterizeCanvas(Canvas& canvas, const DisplayList& list, size_t worker) { }
+		/* FinishCanvas: upload a canvas drawn by RasterizeCanvas, back on the main thread */
+		virtual void FinishCanvas(Canvas& canvas, const DisplayList& list) { }
+
+	protected:
+		TextLayoutCache textLayouts;
+	};
+
 	/* UIBackground: an abstraction for the background of a control */
 	class UIBackground
 	{
 	public:
-		void virtual Render(olc::PixelGameEngine* pge, Rect area, float fElapsedTime) = 0;
+		virtual ~UIBackground() {}
+		void virtual Render(RenderBackend* rb, Rect area, float fElapsedTime) = 0;
+
+		/* Tick: advance anything time based, called once a frame however many controls show the background, and only while one of them is visible and on screen.
+			Only called when Animated is set.  Add to Changes when the background looks different, and the controls showing it redraw. */
+		virtual void Tick(float fElapsedTime) { }
+		bool Animated = false;
+		uint32_t Changes = 0;
+
+	private:
+		friend class ControlBase;
+		/* tickedFrame: the UIContext frame it was last ticked in */
+		uint64_t tickedFrame = 0;
 	};
 
 	/* ControlStyle: determines the appearance of a control */
@@ -186,7 +751,7 @@ namespace RasputinUI
 		}
 
 		/* DeepCopy: Copy the values for everything EXCEPT background, to allow backgrounds to be shared */
-		ControlStyle DeepCopy()
+		ControlStyle DeepCopy() const
 		{
 			ControlStyle result;
 			result.empty = empty;
@@ -198,6 +763,17 @@ namespace RasputinUI
 			result.BorderType = BorderType;
 			return result;
 		}
+
+		/* operator==: whether two styles look the same.  Backgrounds are compared by pointer. */
+		bool operator==(const ControlStyle& other) const
+		{
+			return empty == other.empty && ForegroundColor == other.ForegroundColor
+				&& TextAlign.Horizontal == other.TextAlign.Horizontal && TextAlign.Vertical == other.TextAlign.Vertical
+				&& TextScale == other.TextScale
+				&& Padding.top == other.Padding.top && Padding.right == other.Padding.right && Padding.bottom == other.Padding.bottom && Padding.left == other.Padding.left
+				&& Background == other.Background && BorderType == other.BorderType;
+		}
+		bool operator!=(const ControlStyle& other) const { return !(*this == other); }
 	};
 
 	/* ControlTheme: allows a control to have varied ControlStyle based on it's state (Enabled, Default, Active, Hover) */
@@ -208,7 +784,7 @@ namespace RasputinUI
 		ControlStyle Hover = ControlStyle::Empty();
 		ControlStyle Active = ControlStyle::Empty();
 
-		ControlStyle GetStyle(bool enabled, bool hover, bool active)
+		const ControlStyle& GetStyle(bool enabled, bool hover, bool active) const
 		{
 			if (!enabled && !Disabled.empty)
 				return Disabled;
@@ -220,7 +796,7 @@ namespace RasputinUI
 			return Default;
 		}
 
-		ControlTheme DeepCopy()
+		ControlTheme DeepCopy() const
 		{
 			ControlTheme result;
 			result.Disabled = Disabled.DeepCopy();
@@ -229,1240 +805,5991 @@ namespace RasputinUI
 			result.Active = Active.DeepCopy();
 			return result;
 		}
+
+		bool operator==(const ControlTheme& other) const
+		{
+			return Default == other.Default && Disabled == other.Disabled && Hover == other.Hover && Active == other.Active;
+		}
+		bool operator!=(const ControlTheme& other) const { return !(*this == other); }
 	};
 
-	/* Class: UI   Just a place for common static functions */
-	class UI
+	/* ThemeHandle: a shared, reference counted ControlTheme.  Copying a handle shares the theme, so any number of controls can use one theme for free.
+		Read it with ->, and change it with Edit(), which first makes a copy of its own if anyone else is sharing it (copy on write). */
+	class ThemeHandle
 	{
-	public:
-		static float fBlendFactor; // for alpha function
-		static olc::Pixel TrueAlpha(int32_t x, int32_t y, const olc::Pixel& p, const olc::Pixel& d)
+	private:
+		std::shared_ptr<ControlTheme> theme;
+
+		static const std::shared_ptr<ControlTheme>& blank()
 		{
-#ifdef RASPUTINUI_NO_ALPHA   // in case you dont want to use modified alpha blend
-			float a = (float)(p.a / 255.0f) * fBlendFactor;
-			float c = 1.0f - a;
-			float r = a * (float)p.r + c * (float)d.r;
-			float g = a * (float)p.g + c * (float)d.g;
-			float b = a * (float)p.b + c * (float)d.b;
+			static std::shared_ptr<ControlTheme> result = std::make_shared<ControlTheme>();
+			return result;
+		}
 
-			return olc::Pixel((uint8_t)r, (uint8_t)g, (uint8_t)b); // the original alpha combine
-#else
-			if (d.a ==0 && p.a == 0)
-				return true; // short circuit, both 0 alpha
-			float a = (float)(p.a / 255.0f) * fBlendFactor;
-			float c = 1.0f - a;
-			float r = a * (float)p.r + c * (float)d.r;
-			float g = a * (float)p.g + c * (float)d.g;
-			float b = a * (float)p.b + c * (float)d.b;
+	public:
+		ThemeHandle() : theme(blank()) {}
+		ThemeHandle(const ControlTheme& value) : theme(std::make_shared<ControlTheme>(value)) {}
 
-			uint8_t ra = 255; // what it was defaulting to regardless of incoming alpha, below is the "fix"
-			if (d.a == 0)
-				ra = p.a;
-			else if (p.a == 0)
-				ra = d.a;
-			return olc::Pixel((uint8_t)r, (uint8_t)g, (uint8_t)b, ra); // and set the alpha component
-#endif
+		const ControlTheme* operator->() const { return theme.get(); }
+		const ControlTheme& operator*() const { return *theme; }
+
+		/* Edit: the theme, to change, unshared first if need be.  Remember to Invalidate the controls using it. */
+		ControlTheme& Edit()
+		{
+			if (theme.use_count() > 1)
+				theme = std::make_shared<ControlTheme>(*theme);
+			return *theme;
 		}
 
-		/* OutputText: this handles text overrun of control boundries */
-		static void OutputText(olc::PixelGameEngine* pge, olc::vi2d location, olc::vi2d size, std::string text, ControlStyle style)
+		bool operator==(const ThemeHandle& other) const { return theme == other.theme; }
+		bool operator!=(const ThemeHandle& other) const { return theme != other.theme; }
+
+		/* ControlDefault: the theme controls start with, shared until they edit it.  Just so by default objects show text. */
+		static const ThemeHandle& ControlDefault()
 		{
-			pge->DrawString(location, text, style.ForegroundColor, style.TextScale.x);
+			static ThemeHandle theme = []() { ControlTheme t; t.Default.ForegroundColor = olc::WHITE; return ThemeHandle(t); }();
+			return theme;
 		}
+	};
 
-		/* Draw Bevel: draw the specified bevel around the control */
-		static void DrawBevel(olc::PixelGameEngine* pge, RUI::BorderType borderType, Rect area)
+	/* StyleRule: the properties a StyleSheet rule sets, anything it doesn't set is left to less specific rules.
+		The setters return the rule, so they can be chained: sheet.Rule("TextEdit").Foreground(olc::BLACK).Border(RUI::BorderType::Sunken); */
+	class StyleRule
+	{
+	public:
+		enum Property : uint32_t
 		{
-			if (borderType == RUI::BorderType::None)
-				return;
-			olc::Pixel Highlight1 = olc::Pixel(255, 255, 255);
-			olc::Pixel Highlight2 = olc::Pixel(227, 227, 227);
-			olc::Pixel Shadow1 = olc::Pixel(105,105,105);
-			olc::Pixel Shadow2 = olc::Pixel(160,160,160);
+			ForegroundColor = 1, TextAlign = 2, TextScale = 4, Padding = 8, Background = 16, BorderType = 32
+		};
 
-			olc::Pixel t1 = Highlight1;
-			olc::vi2d spos = area.Position;
+		StyleRule& Foreground(olc::Pixel val) { values.ForegroundColor = val; return set(ForegroundColor); }
+		StyleRule& Align(FullAlignment val) { values.TextAlign = val; return set(TextAlign); }
+		StyleRule& Scale(olc::vf2d val) { values.TextScale = val; return set(TextScale); }
+		StyleRule& Pad(Spacing val) { values.Padding = val; return set(Padding); }
+		StyleRule& Back(UIBackground* val) { values.Background = val; return set(Background); }
+		StyleRule& Border(RUI::BorderType val) { values.BorderType = val; return set(BorderType); }
 
-			switch (borderType)
-			{
-			case RUI::BorderType::Sunken:
-				// default, already set
-				break;
-			case RUI::BorderType::Raised:
-				// swap the colors
-				Highlight1 = Shadow1;
-				Shadow1 = t1;
-				t1 = Highlight2;
-				Highlight2 = Shadow2;
-				Shadow2 = t1;
-				break;
-			case RUI::BorderType::Solid:
-			{
-				// special case, easier to draw a rect
-				pge->DrawRect(spos, area.Size, Shadow1);
-				return;
-				break;
-			}
-			}
-			
+		/* ApplyTo: copy the properties this rule sets onto a style */
+		void ApplyTo(ControlStyle& style) const
+		{
+			if (props & ForegroundColor) style.ForegroundColor = values.ForegroundColor;
+			if (props & TextAlign) style.TextAlign = values.TextAlign;
+			if (props & TextScale) style.TextScale = values.TextScale;
+			if (props & Padding) style.Padding = values.Padding;
+			if (props & Background) style.Background = values.Background;
+			if (props & BorderType) style.BorderType = values.BorderType;
+		}
 
-			pge->FillRect({ spos.x + 1,spos.y + 1 }, { area.Size.x - 2,1 }, Shadow1);
-			pge->FillRect(spos, { area.Size.x,1 }, Shadow2);
-
-			pge->FillRect({ spos.x + 1, spos.y + (area.Size.y - 1) }, { area.Size.x - 2,1 }, Highlight1);
-			pge->FillRect({ spos.x + 2, spos.y + (area.Size.y - 2) }, { area.Size.x - 4,1 }, Highlight2);
-
-			pge->FillRect({ spos.x + (area.Size.x - 2), spos.y + 2 }, { 1,area.Size.y - 3 }, Highlight2);
-			pge->FillRect({ spos.x + (area.Size.x - 1), spos.y + 1 }, { 1,area.Size.y - 1 }, Highlight1);
-
-			pge->FillRect({ spos.x, spos.y + 1 }, { 1,area.Size.y - 1 }, Shadow2);
-			pge->FillRect({ spos.x + 1, spos.y + 2 }, { 1,area.Size.y - 3 }, Shadow1);
-		}
-
-		/* AlignTextIn: A convenience function to calculate position within a rectangle given an alignment, size, and scale. */
-		static olc::vf2d AlignTextIn(olc::PixelGameEngine* pge, std::string text, Rect destination, FullAlignment textAlign, olc::vf2d scale)
-		{
-			olc::vf2d spos = destination.Position;
-
-			olc::vi2d tsize = pge->GetTextSize(text);
-			tsize = { (int)(tsize.x * scale.x),(int)(tsize.y * scale.y) };
+	private:
+		friend class StyleSheet;
+		StyleRule(StyleSheet* sheet) : sheet(sheet) {}
 
-			if (textAlign.Horizontal == RUI::Alignment::Far)
-				spos.x = destination.right() - tsize.x;
-			else if (textAlign.Horizontal == RUI::Alignment::Center)
-				spos.x = destination.Position.x + ((destination.Size.x - tsize.x) / 2);
+		StyleSheet* sheet;
+		ControlStyle values;
+		uint32_t props = 0;
 
-			if (textAlign.Vertical == RUI::Alignment::Far)
-				spos.y = (float)(destination.bottom() - tsize.y);
-			else if (textAlign.Vertical == RUI::Alignment::Center)
-				spos.y = destination.Position.y + ((destination.Size.y - tsize.y) / 2);
+		/* the compiled selector: interned type and name (-1 for any), the theme state it styles, and where it sorts */
+		int type = -1;
+		int name = -1;
+		int state = 0;
+		uint64_t order = 0;
 
-			return spos;
-		}
+		inline StyleRule& set(Property prop);
 	};
-	float UI::fBlendFactor = 1.0f;
 
-	/* SolidBackground: creates a control background of a solid color */
-	class SolidBackground : public UIBackground
-	{
-	private:
-		SolidBackground() {}
-	public:
-		static SolidBackground* BLANK; // explicitly have a transparent one, as it is the default
-		olc::Pixel Color = olc::BLANK;
-		SolidBackground(olc::Pixel clr)
-		{
-			Color = clr;
-		}
-		void Render(olc::PixelGameEngine* pge, Rect area, float fElapsedTime) override
-		{
-			olc::Pixel::Mode pMode = pge->GetPixelMode();
-			//pge->SetPixelMode(olc::Pixel::ALPHA);
-			pge->SetPixelMode(UI::TrueAlpha);
-			pge->FillRect(area.Position, area.Size, Color);
-			pge->SetPixelMode(pMode);
-		}
-	};
-	SolidBackground* SolidBackground::BLANK = new SolidBackground(olc::BLANK);
+	/* StyleSheet: cascading rules that theme controls by type, Name and state, instead of setting every control's Theme by hand.
+		Selectors are written "Type#Name:state", and every part is optional: "*" or "" matches everything, "ListControl", "#okButton", "Slider:hover".
+		The states are hover, active and disabled, a rule without one styles the Default state, which the other states start from.
+		More specific rules win (a Name over a type over neither), then later rules.
 
-	/* DecalBackground: creates a control background with a single decal.  It can be scaled, tinted, and aligned */
-	class SpriteBackground : public UIBackground
+		Give it to UIManager::SetStyleSheet.  Controls restyle themselves in the update pass whenever the sheet changes,
+		and only redraw if their resolved theme looks different.  Controls no rule matches keep the Theme they have. */
+	class StyleSheet
 	{
-	private:
-		SpriteBackground();
 	public:
-		olc::Sprite* oSprite;
-		FullAlignment ImageAlignment;
-		int ImageScale;
-		//olc::Pixel Tint = olc::WHITE;
-
-		SpriteBackground(olc::Sprite* sprite, FullAlignment alignment = { RUI::Alignment::Center, RUI::Alignment::Center }, int scale = 1/*, olc::Pixel tint = olc::WHITE*/)
+		/* Rule: add a rule for a selector, set its properties with the returned StyleRule.  Rules stay valid as long as the sheet. */
+		StyleRule& Rule(const std::string& selector)
 		{
-			oSprite = sprite;
-			ImageAlignment = alignment;
-			ImageScale = scale;
-			//Tint = tint;
+			rules.push_back(StyleRule(this));
+			StyleRule& rule = rules.back();
+			compile(selector, rule);
+			rule.order = (uint64_t)specificity(rule) << 32 | (uint64_t)(rules.size() - 1);
+
+			if (rule.name >= 0)
+				addTo(byName, rule.name, &rule);
+			else if (rule.type >= 0)
+				addTo(byType, rule.type, &rule);
+			else
+				universal.push_back(&rule);
+			Changed();
+			return rule;
 		}
 
-		void Render(olc::PixelGameEngine* pge, Rect area, float fElapsedTime) override
+		/* Clear: remove every rule */
+		void Clear()
 		{
-			olc::vf2d spos = area.Position;
-			olc::vi2d dsize = { oSprite->width, oSprite->height };
-			dsize *= ImageScale;
-			if (ImageAlignment.Horizontal == RUI::Alignment::Far)
-				spos.x = (float)(area.right() - dsize.x);
-			else if (ImageAlignment.Horizontal == RUI::Alignment::Center)
-				spos.x += (area.Size.x - dsize.x) / 2;
-
-			if (ImageAlignment.Vertical == RUI::Alignment::Far)
-				spos.y = (float)(area.bottom() - dsize.y);
-			else if (ImageAlignment.Vertical == RUI::Alignment::Center)
-				spos.y += (area.Size.y - dsize.y) / 2;
-
-			pge->DrawSprite(spos, oSprite, ImageScale);
+			rules.clear();
+			universal.clear();
+			byType.clear();
+			byName.clear();
+			ids.clear();
+			Changed();
 		}
-	};
-
-	/* TiledDecalBackground: creates a control background that tiles a decal on the X and Y axis.  It can be scaled and tinted */
-	class TiledSpriteBackground : public UIBackground
-	{
-	private:
-		TiledSpriteBackground();
-	public:
-		olc::Sprite* oSprite;
-		int ImageScale;
-		//olc::Pixel Tint = olc::WHITE;
 
-		TiledSpriteBackground(olc::Sprite* decal, int scale = 1 /*, olc::Pixel tint = olc::WHITE*/)
+		/* Changed: the rules changed, every control has to resolve its theme again.  Rule setters call it for you. */
+		void Changed()
 		{
-			oSprite = decal;
-			ImageScale = scale;
-			//Tint = tint;
+			generation++;
+			resolved.clear();
 		}
 
-		void Render(olc::PixelGameEngine* pge, Rect area, float fElapsedTime) override
+		/* Generation: changes whenever the rules do */
+		uint32_t Generation() const { return generation; }
+
+		/* Resolve: the theme for a control of the given type and name, false if no rule matches it.
+			Controls with the same type and name share one resolved theme. */
+		bool Resolve(const char* typeName, const std::string& name, ThemeHandle& result)
 		{
-			olc::vi2d dsize = { oSprite->width, oSprite->height };
-			dsize *= ImageScale;
+			int t = find(typeName);
+			int n = name.empty() ? -1 : find(name);
+			uint64_t key = (uint64_t)(uint32_t)t << 32 | (uint32_t)n;
 
-			int cols = area.Size.x / dsize.x;
-			int rows = area.Size.y / dsize.y;
+			auto cached = resolved.find(key);
+			if (cached != resolved.end())
+			{
+				if (!cached->second.second)
+					return false;
+				result = cached->second.first;
+				return true;
+			}
 
-			for (int y = 0; y < area.Size.y; y += dsize.y)
+			matches.clear();
+			for (auto rule : universal)
+				matches.push_back(rule);
+			if (t >= 0 && t < (int)byType.size())
+				for (auto rule : byType[t])
+					if (rule->name < 0)
+						matches.push_back(rule);
+			if (n >= 0 && n < (int)byName.size())
+				for (auto rule : byName[n])
+					if (rule->type < 0 || rule->type == t)
+						matches.push_back(rule);
+
+			bool matched = !matches.empty();
+			if (matched)
 			{
-				for (int x = 0; x < area.Size.x; x += dsize.x)
+				std::sort(matches.begin(), matches.end(), [](const StyleRule* a, const StyleRule* b) { return a->order < b->order; });
+
+				ControlTheme theme = *ThemeHandle::ControlDefault();
+				for (auto rule : matches)
+					if (rule->state == 0)
+						rule->ApplyTo(theme.Default);
+				ControlStyle* states[4] = { &theme.Default, &theme.Hover, &theme.Active, &theme.Disabled };
+				for (int state = 1; state < 4; state++)
 				{
-					int w = dsize.x;
-					int h = dsize.y;
-
-					if (x + dsize.x > area.Size.x)
-						w = (area.Size.x - x);
-					if (y + dsize.y > area.Size.y)
-						h = (area.Size.y - y);
-
-					olc::vi2d loc1 = { area.Position.x + x,area.Position.y + y };
-					olc::vi2d siz1 = { w,h };
-					pge->DrawPartialSprite(loc1, oSprite, { 0,0 }, siz1, ImageScale);
-
+					for (auto rule : matches)
+					{
+						if (rule->state != state)
+							continue;
+						if (states[state]->empty)
+							*states[state] = theme.Default.DeepCopy();
+						rule->ApplyTo(*states[state]);
+					}
 				}
+				result = ThemeHandle(theme);
 			}
+			resolved[key] = { result, matched };
+			return matched;
 		}
-	};
 
-	/* ControlBase: the base control for the UI system.
-		This can be used as a label, a panel, a button, an image, just about anything.
-		You can also derive from it and create addition custom controls, as well as build composite controls.
-	*/
-	class ControlBase
-	{
-	protected:
-		/* Location: The controls location and size, relative to its parent */
-		Rect Location;
+	private:
+		std::deque<StyleRule> rules;
+		uint32_t generation = 1;
 
-		bool CanvasValid = false;
+		/* ids: every type and name used in a selector, interned so matching is integer compares */
+		std::unordered_map<std::string, int> ids;
 
-		std::string Text;
+		/* the rules, bucketed by the most specific thing they select on */
+		std::vector<StyleRule*> universal;
+		std::vector<std::vector<StyleRule*>> byType;
+		std::vector<std::vector<StyleRule*>> byName;
 
-	public:
-		/* PopToTop: use this function to grab the top level parent of this control and pop him to the front of z order */
-		virtual void PopToTop()
-		{
-			if (Parent && Parent->Parent == NULL)
-			{
-				Parent->Controls.remove(this);
-				Parent->Controls.push_back(this);
-			}
-			else if (Parent)
-			{
-				Parent->PopToTop();
-			}
-		}
+		/* resolved: themes already resolved this generation, by type and name */
+		std::unordered_map<uint64_t, std::pair<ThemeHandle, bool>> resolved;
+		std::vector<const StyleRule*> matches;
 
-		/* SetPosition: set the position of the control, relative to its parent */
-		void SetPosition(olc::vi2d loc)
+		int intern(const std::string& id)
 		{
-			Location.Position = loc;
-			OnMove.Invoke(this);
+			auto it = ids.find(id);
+			if (it != ids.end())
+				return it->second;
+			int result = (int)ids.size();
+			ids[id] = result;
+			return result;
 		}
 
-		void SetPosition(int x, int y)
-		{
-			SetPosition({ x,y });
-		}
-		/* Position: get the position of the control, relative to its parent */
-		olc::vi2d Position()
+		int find(const std::string& id) const
 		{
-			return Location.Position;
+			auto it = ids.find(id);
+			return it == ids.end() ? -1 : it->second;
 		}
 
-		/* SetSize: set the size of the control */
-		void SetSize(int w, int h)
-		{
-			SetSize({ w, h });
-		}
-		void SetSize(olc::vi2d size)
+		static void addTo(std::vector<std::vector<StyleRule*>>& buckets, int id, StyleRule* rule)
 		{
-			Location.Size = size;
-			OnResize.Invoke(this);
-			Invalidate();
+			if ((int)buckets.size() <= id)
+				buckets.resize(id + 1);
+			buckets[id].push_back(rule);
 		}
 
-		/* Size: get the size of the control */
-		olc::vi2d Size()
+		static uint32_t specificity(const StyleRule& rule)
 		{
-			return Location.Size;
+			return (rule.name >= 0 ? 2 : 0) + (rule.type >= 0 ? 1 : 0);
 		}
 
-		void Invalidate()
+		/* compile: split "Type#Name:state" into the rule's interned ids and state */
+		void compile(const std::string& selector, StyleRule& rule)
 		{
-			CanvasValid = false;
+			size_t colon = selector.find(':');
+			std::string state = colon == std::string::npos ? "" : selector.substr(colon + 1);
+			std::string head = selector.substr(0, colon);
+			size_t hash = head.find('#');
+			std::string type = head.substr(0, hash);
+			std::string name = hash == std::string::npos ? "" : head.substr(hash + 1);
+
+			rule.type = (type.empty() || type == "*") ? -1 : intern(type);
+			rule.name = name.empty() ? -1 : intern(name);
+			if (state == "hover")
+				rule.state = 1;
+			else if (state == "active")
+				rule.state = 2;
+			else if (state == "disabled")
+				rule.state = 3;
+			else
+				rule.state = 0;
 		}
+	};
 
-		/* OnClick: Event handler, invoked when any (left,right,middle) mouse buttons are pressed while over this control, AND it was enabled. */
-		EventHandler1Param<int> OnClick;
-		/* OnMouseDown: Event handler, invoked when any (left,right,middle) mouse buttons enters the pressed state while over this control, AND it was enabled. */
-		EventHandler1Param<int> OnMouseDown;
-		/* OnMouseDown: Event handler, invoked when any (left,right,middle) mouse buttons enters the released state while over this control OR the control was the last target of mouse down, AND it was enabled. */
-		EventHandler1Param<int> OnMouseUp;
-		/* OnMouseEnter: Event Handler, invoked when the mouse STARTS hovering over this control */
-		EventHandler OnMouseEnter;
-		/* OnMouseLeave: Event Handler, invoked when the mouse STOPS hovering over this control */
-		EventHandler OnMouseLeave;
-		/* OnMouseMove: Event Handler, invoked when the mouse moves while hovering over this control, or the control is the current mouse down target */
-		EventHandler OnMouseMove;
-		/* OnFocus: Event Handler, called when this control gains input focus */
-		EventHandler OnFocus;
-		/* OnFocus: Event Handler, called when this control loses input focus */
-		EventHandler OnBlur;
-		/* OnMove: Event Handler, called when this control's location changes */
-		EventHandler OnMove;
-		/* OnResize: Event Handler, called when this control's size changes */
-		EventHandler OnResize;
-
-		/* Parent: The control's parent if any */
-		ControlBase* Parent = NULL;
-
-		/* Theme: the ControlTheme for this control */
-		ControlTheme Theme;
-
-		/* Text: Any text to display on this control.  Text Scale and Text Align will be used to determine its size and location */
-		std::string GetText() {return Text;}
-		void SetText(std::string val)
-		{ 
-			if (Text != val)
-			{
-				Text = val;
-				Invalidate();
-			}
-		}
+	StyleRule& StyleRule::set(Property prop)
+	{
+		props |= prop;
+		sheet->Changed();
+		return *this;
+	}
 
-		/* Active: wether the control is currently "Active" is used for an additional state to be used differently as needed.  In list items, it can serve as the selected item color, for example. */
-		bool Active = false;
+	/* InputEvent: one change in the input, a key or mouse button going down or up, or the mouse moving */
+	struct InputEvent
+	{
+		enum EventType : uint8_t { MouseMove, MouseDown, MouseUp, KeyDown, KeyUp };
 
-		/* Active: wether the control is currently "Active" is used for an additional state to be used differently as needed.  In list items, it can serve as the selected item color, for example. */
-		bool Visible = true;
+		EventType Type = MouseMove;
+		int Code = 0; // the olc::Key, or the mouse button
+		olc::vi2d Pos = { 0,0 }; // where the mouse moved to
+		double Time = 0; // seconds since the input began, the time of the frame it was handled in
+	};
 
-		/* Enabled: wether the control uses its Disabled state (if not .empty), and wether it responds to hover and click state transitions */
-		bool Enabled = true;
+	/* InputState: the input the UIManager handles in a frame, as the frame's InputEvents and the mouse and key states they leave.
+		Read from the engine, played back from an InputRecording, or filled in by hand when running headless:
 
-		/* CanFocus: Determines wether the control can take input focus.  If it cant, it can still remove the focus of the current control if selected. */
-		bool CanFocus = false;
+		 input.BeginFrame(fElapsedTime);
+		 input.Push({ InputEvent::KeyDown, olc::Key::A });
+		 ui.Update(fElapsedTime, input);
 
-		/* Name: entirely an external ID to allow you to track where an event came from */
-		std::string Name = "";
+		Keep one InputState from frame to frame, keys and buttons stay held until their up event. */
+	struct InputState
+	{
+		olc::vi2d MousePos = { 0,0 };
+		olc::HWButton Mouse[3];
 
-		/* Controls: all Controls ARE containers, so we need a list of controls, to render and manage user input */
-		std::list<ControlBase*> Controls;
+		/* Events: this frame's events, in the order they happened */
+		std::vector<InputEvent> Events;
 
-		/* Hovering: is the mouse currently hovering over this control... don't set it unless you are writing an input handler, but it can be read any time */
-		bool Hovering = false;
+		/* Time: seconds since the input began */
+		double Time = 0;
 
-		/* Constructor: Basic constructor for a control to create it within a parent */
-		ControlBase(Rect location, ControlBase* parent = NULL)
+		/* BeginFrame: start a new frame fElapsedTime after the last, clearing the events and the pressed and released states */
+		void BeginFrame(float fElapsedTime)
 		{
-			Theme.Default.ForegroundColor = olc::WHITE;
-			Location = location;
-			Parent = parent;
-			if (Parent != NULL)
-			{
-				Parent->Controls.push_back(this);
-			}
+			Time += fElapsedTime;
+			Events.clear();
+			for (int i = 0; i < 3; i++)
+				Mouse[i].bPressed = Mouse[i].bReleased = false;
+			for (int i = 0; i < olc::Key::ENUM_END; i++)
+				keys[i].bPressed = keys[i].bReleased = false;
 		}
 
-		/* Constructor: create a control within a parent and set its theme */
-		ControlBase(Rect location, ControlTheme theme, ControlBase* parent = NULL)
+		/* Push: add an event to this frame, and apply it */
+		void Push(InputEvent e)
 		{
-			Location = location;
-			Parent = parent;
-			ApplyTheme(theme);
-
-			if (Parent != NULL)
+			e.Time = Time;
+			Events.push_back(e);
+			olc::HWButton* button = NULL;
+			switch (e.Type)
 			{
-				Parent->Controls.push_back(this);
+			case InputEvent::MouseMove:
+				MousePos = e.Pos;
+				return;
+			case InputEvent::MouseDown:
+			case InputEvent::MouseUp:
+				if (e.Code < 0 || e.Code >= 3)
+					return;
+				button = &Mouse[e.Code];
+				break;
+			case InputEvent::KeyDown:
+			case InputEvent::KeyUp:
+				if (e.Code <= 0 || e.Code >= olc::Key::ENUM_END)
+					return;
+				button = &keys[e.Code];
+				break;
 			}
+			if (button == NULL)
+				return; // not an event type we know
+			bool down = e.Type == InputEvent::MouseDown || e.Type == InputEvent::KeyDown;
+			button->bPressed |= down;
+			button->bReleased |= !down;
+			button->bHeld = down;
 		}
 
-		/* Constructor: base simple constructor for future expansion and complex custom controls */
-		ControlBase() { Theme.Default.ForegroundColor = olc::WHITE; } // just so by default objects show text
+		/* Key: the state of a key this frame */
+		const olc::HWButton& Key(olc::Key k) const { return keys[k > 0 && k < olc::Key::ENUM_END ? k : 0]; }
 
-		/* MouseOver: meant to be handled in the OnUserUpdate call in olcPixelGameEngine, with the mouse coordinates, to handle mouse interaction */
-		virtual ControlBase* MouseOver(olc::vi2d mpos)
+		/* Shifted: shift is down */
+		bool Shifted() const { return Key(olc::SHIFT).bPressed || Key(olc::SHIFT).bHeld; }
+
+	private:
+		olc::HWButton keys[olc::Key::ENUM_END];
+	};
+
+	/* Class: UI   Just a place for common static functions */
+	class UI
+	{
+	public:
+		static float fBlendFactor; // for alpha function
+		static olc::vi2d MousePos; // the mouse position the UIManager is currently handling
+
+		/* TypedKeys: the characters typed this frame on the keys the text controls support, in the order they were typed, 0x08 is backspace */
+		static std::string TypedKeys(const InputState& input)
 		{
-			if (Visible)
+			static const olc::Key keyList[41] = {
+										olc::Key::A,olc::Key::B,olc::Key::C,olc::Key::D,olc::Key::E,olc::Key::F,olc::Key::G,olc::Key::H,olc::Key::I,olc::Key::J,
+										olc::Key::K,olc::Key::L,olc::Key::M,olc::Key::N,olc::Key::O,olc::Key::P,olc::Key::Q,olc::Key::R,olc::Key::S,olc::Key::T,
+										olc::Key::U,olc::Key::V,olc::Key::W,olc::Key::X,olc::Key::Y,olc::Key::Z,
+										olc::Key::K0,olc::Key::K1,olc::Key::K2,olc::Key::K3,olc::Key::K4,olc::Key::K5,olc::Key::K6,olc::Key::K7,olc::Key::K8,olc::Key::K9,
+										olc::Key::SPACE, olc::Key::PERIOD, olc::Key::MINUS, olc::Key::COMMA, olc::Key::BACK
+			};
+
+			// the values of the keyList in characters, first set is shifted, second set is unshifted
+			static const char keyValues[82] = {
+										'A','B','C','D','E','F','G','H','I','J','K','L','M','N','O','P','Q','R','S','T','U','V','W','X','Y','Z',
+										')','!','@','#','$','%','^','&','*','(',
+										' ','>','-', '<', 0x08,
+										'a','b','c','d','e','f','g','h','i','j','k','l','m','n','o','p','q','r','s','t','u','v','w','x','y','z',
+										'0','1','2','3','4','5','6','7','8','9',
+										' ','.','-', ',', 0x08
+			};
+
+			std::string result;
+			bool shifted = input.Shifted();
+			for (const InputEvent& e : input.Events)
 			{
-				Rect sRect;
-				sRect.Position = ScreenPos();
-				sRect.Size = Location.Size;
-				if (Enabled && sRect.Contains(mpos))
-				{
-					for (std::list<ControlBase*>::reverse_iterator control = Controls.rbegin(); control != Controls.rend(); ++control)
-					{
-						ControlBase* res = (*control)->MouseOver(mpos);
-						if (res != NULL)
-						{
-							Hovering = false;
-							return res;
-						}
-					}
-					Hovering = true;
-					return this;
-				}
+				if (e.Type != InputEvent::KeyDown)
+					continue;
+				for (int i = 0; i < 41; i++)
+					if (keyList[i] == e.Code)
+						result += shifted ? keyValues[i] : keyValues[i + 41];
 			}
-			Hovering = false;
-			return NULL;
+			return result;
 		}
-
-		/* ApplyTheme: Change the theme of a control.  individual aspects of a theme can also be changed at any time. */
-		void ApplyTheme(ControlTheme theme)
+		static olc::Pixel TrueAlpha(int32_t x, int32_t y, const olc::Pixel& p, const olc::Pixel& d)
 		{
-			Theme = theme.DeepCopy();
-		}
-
-		/* Focus: Give this control input focus. */
-		virtual void Focus()
+#ifdef RASPUTINUI_NO_ALPHA   // in case you dont want to use modified alpha blend
+			float a = (float)(p.a / 255.0f) * fBlendFactor;
+			float c = 1.0f - a;
+			float r = a * (float)p.r + c * (float)d.r;
+			float g = a * (float)p.g + c * (float)d.g;
+			float b = a * (float)p.b + c * (float)d.b;
+
+			return olc::Pixel((uint8_t)r, (uint8_t)g, (uint8_t)b); // the original alpha combine
+#else
+			if (d.a ==0 && p.a == 0)
+				return true; // short circuit, both 0 alpha
+			float a = (float)(p.a / 255.0f) * fBlendFactor;
+			float c = 1.0f - a;
+			float r = a * (float)p.r + c * (float)d.r;
+			float g = a * (float)p.g + c * (float)d.g;
+			float b = a * (float)p.b + c * (float)d.b;
+
+			uint8_t ra = 255; // what it was defaulting to regardless of incoming alpha, below is the "fix"
+			if (d.a == 0)
+				ra = p.a;
+			else if (p.a == 0)
+				ra = d.a;
+			return olc::Pixel((uint8_t)r, (uint8_t)g, (uint8_t)b, ra); // and set the alpha component
+#endif
+		}
+
+		/* OutputText: this handles text overrun of control boundries */
+		static void OutputText(RenderBackend* rb, olc::vi2d location, olc::vi2d size, std::string text, ControlStyle style)
 		{
-			OnFocus.Invoke(this);
-		};
+			rb->DrawString(location, text, style.ForegroundColor, (uint32_t)style.TextScale.x);
+		}
 
-		/* Blur: remove the current input focus. */
-		virtual void Blur()
+		/* Draw Bevel: draw the specified bevel around the control */
+		static void DrawBevel(RenderBackend* rb, RUI::BorderType borderType, Rect area)
 		{
-			OnBlur.Invoke(this);
-		};
+			if (borderType != RUI::BorderType::None)
+				rb->DrawBevel(borderType, area);
+		}
 
-		/* MouseEnter: The mouse started hovering over your control. */
-		virtual void MouseEnter()
+		/* BevelRects: the rectangles of a border, filled with fill(pos, size, color), or for a Solid border outlined with outline(pos, size, color).
+			Shared by every way a bevel is drawn, so they all look the same. */
+		template <class Fill, class Outline>
+		static void BevelRects(RUI::BorderType borderType, Rect area, Fill fill, Outline outline)
 		{
-			OnMouseEnter.Invoke(this);
-		};
+			if (borderType == RUI::BorderType::None)
+				return;
+			olc::Pixel Highlight1 = olc::Pixel(255, 255, 255);
+			olc::Pixel Highlight2 = olc::Pixel(227, 227, 227);
+			olc::Pixel Shadow1 = olc::Pixel(105,105,105);
+			olc::Pixel Shadow2 = olc::Pixel(160,160,160);
 
-		/* MouseLeave: The mouse was hovering over your control, and has now left. */
-		virtual void MouseLeave()
+			olc::Pixel t1 = Highlight1;
+			olc::vi2d spos = area.Position;
+
+			switch (borderType)
+			{
+			case RUI::BorderType::Sunken:
+				// default, already set
+				break;
+			case RUI::BorderType::Raised:
+				// swap the colors
+				Highlight1 = Shadow1;
+				Shadow1 = t1;
+				t1 = Highlight2;
+				Highlight2 = Shadow2;
+				Shadow2 = t1;
+				break;
+			case RUI::BorderType::Solid:
+			{
+				// special case, easier to draw a rect
+				outline(spos, area.Size, Shadow1);
+				return;
+				break;
+			}
+			default:
+				break;
+			}
+
+			fill({ spos.x + 1,spos.y + 1 }, { area.Size.x - 2,1 }, Shadow1);
+			fill(spos, { area.Size.x,1 }, Shadow2);
+
+			fill({ spos.x + 1, spos.y + (area.Size.y - 1) }, { area.Size.x - 2,1 }, Highlight1);
+			fill({ spos.x + 2, spos.y + (area.Size.y - 2) }, { area.Size.x - 4,1 }, Highlight2);
+
+			fill({ spos.x + (area.Size.x - 2), spos.y + 2 }, { 1,area.Size.y - 3 }, Highlight2);
+			fill({ spos.x + (area.Size.x - 1), spos.y + 1 }, { 1,area.Size.y - 1 }, Highlight1);
+
+			fill({ spos.x, spos.y + 1 }, { 1,area.Size.y - 1 }, Shadow2);
+			fill({ spos.x + 1, spos.y + 2 }, { 1,area.Size.y - 3 }, Shadow1);
+		}
+
+		/* AlignTextIn: A convenience function to calculate position within a rectangle given an alignment, size, and scale. */
+		static olc::vf2d AlignTextIn(RenderBackend* rb, std::string text, Rect destination, FullAlignment textAlign, olc::vf2d scale)
 		{
-			OnMouseLeave.Invoke(this);
-		};
+			return AlignTextIn(rb->GetTextSize(text), destination, textAlign, scale);
+		}
 
-		/* MouseDown: Event when a mouse is in the bPressed state on this control. */
-		virtual void MouseDown(int mButton)
+		/* AlignTextIn: the same, for text already measured (unscaled) */
+		static olc::vf2d AlignTextIn(olc::vi2d tsize, Rect destination, FullAlignment textAlign, olc::vf2d scale)
 		{
-			OnMouseDown.Invoke(this, mButton);
-		};
+			olc::vf2d spos = destination.Position;
 
-		/* MouseUp: Event when a mouse is in the bReleased state, to the control previously notified by mousedown. */
-		virtual void MouseUp(int mButton)
+			tsize = { (int)(tsize.x * scale.x),(int)(tsize.y * scale.y) };
+
+			if (textAlign.Horizontal == RUI::Alignment::Far)
+				spos.x = destination.right() - tsize.x;
+			else if (textAlign.Horizontal == RUI::Alignment::Center)
+				spos.x = destination.Position.x + ((destination.Size.x - tsize.x) / 2);
+
+			if (textAlign.Vertical == RUI::Alignment::Far)
+				spos.y = (float)(destination.bottom() - tsize.y);
+			else if (textAlign.Vertical == RUI::Alignment::Center)
+				spos.y = destination.Position.y + ((destination.Size.y - tsize.y) / 2);
+
+			return spos;
+		}
+	};
+
+	inline void RenderBackend::DrawBevel(RUI::BorderType borderType, Rect area)
+	{
+		UI::BevelRects(borderType, area,
+			[this](olc::vi2d pos, olc::vi2d size, olc::Pixel p) { FillRect(pos, size, p); },
+			[this](olc::vi2d pos, olc::vi2d size, olc::Pixel p) { DrawRect(pos, size, p); });
+	}
+
+	float UI::fBlendFactor = 1.0f;
+	olc::vi2d UI::MousePos = { 0,0 };
+
+	/* Raster: CPU drawing onto an olc::Sprite, with the same results the engine gives when drawing with UI::TrueAlpha.
+		Used by the backends that do not draw through olcPixelGameEngine. */
+	class Raster
+	{
+	public:
+		/* BlendPixel: UI::TrueAlpha in integer math, the reference for the span kernels.  Colors can be one step off the float version. */
+		static inline olc::Pixel BlendPixel(olc::Pixel p, olc::Pixel d)
 		{
-			OnMouseUp.Invoke(this, mButton);
+			if (p.a == 255)
+				return p;
+			if (p.a == 0)
+				return d.a == 0 ? olc::Pixel(1, 0, 0, 0) : d; // what TrueAlpha gives when both are clear
+			uint32_t c = 255 - p.a;
+			return olc::Pixel((uint8_t)div255(p.r * p.a + d.r * c), (uint8_t)div255(p.g * p.a + d.g * c), (uint8_t)div255(p.b * p.a + d.b * c), d.a == 0 ? p.a : 255);
+		}
+
+		/* FillSpan: blend p over count pixels.  Opaque colors are a plain fill. */
+		static void FillSpan(olc::Pixel* dst, int count, olc::Pixel p)
+		{
+			if (!kernels())
+			{
+				for (int i = 0; i < count; i++)
+					dst[i] = UI::TrueAlpha(0, 0, p, dst[i]);
+				return;
+			}
+			if (p.a == 255)
+			{
+				std::fill((uint32_t*)dst, (uint32_t*)dst + count, p.n); // as words, so it vectorizes
+				return;
+			}
+			int i = 0;
+			if (p.a != 0)
+			{
+#if defined(RASPUTINUI_AVX2)
+				{
+					const __m256i zero = _mm256_setzero_si256();
+					const __m256i one = _mm256_set1_epi16(1);
+					const __m256i src = _mm256_set_epi16(0, p.b * p.a, p.g * p.a, p.r * p.a, 0, p.b * p.a, p.g * p.a, p.r * p.a, 0, p.b * p.a, p.g * p.a, p.r * p.a, 0, p.b * p.a, p.g * p.a, p.r * p.a);
+					const __m256i inv = _mm256_set1_epi16(255 - p.a);
+					const __m256i amask = _mm256_set1_epi32((int)0xFF000000);
+					const __m256i pa = _mm256_set1_epi32((int)((uint32_t)p.a << 24));
+					for (; i + 8 <= count; i += 8)
+					{
+						__m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+						__m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), inv), src);
+						__m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), inv), src);
+						lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(lo, one), _mm256_srli_epi16(lo, 8)), 8);
+						hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(hi, one), _mm256_srli_epi16(hi, 8)), 8);
+						__m256i clear = _mm256_cmpeq_epi32(_mm256_and_si256(d, amask), zero);
+						__m256i alpha = _mm256_or_si256(_mm256_and_si256(clear, pa), _mm256_andnot_si256(clear, amask));
+						__m256i res = _mm256_or_si256(_mm256_andnot_si256(amask, _mm256_packus_epi16(lo, hi)), alpha);
+						_mm256_storeu_si256((__m256i*)(dst + i), res);
+					}
+				}
+#endif
+#if defined(RASPUTINUI_SSE2)
+				{
+					const __m128i zero = _mm_setzero_si128();
+					const __m128i one = _mm_set1_epi16(1);
+					const __m128i src = _mm_set_epi16(0, p.b * p.a, p.g * p.a, p.r * p.a, 0, p.b * p.a, p.g * p.a, p.r * p.a);
+					const __m128i inv = _mm_set1_epi16(255 - p.a);
+					const __m128i amask = _mm_set1_epi32((int)0xFF000000);
+					const __m128i pa = _mm_set1_epi32((int)((uint32_t)p.a << 24));
+					for (; i + 4 <= count; i += 4)
+					{
+						__m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+						__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv), src);
+						__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv), src);
+						lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, one), _mm_srli_epi16(lo, 8)), 8);
+						hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, one), _mm_srli_epi16(hi, 8)), 8);
+						__m128i clear = _mm_cmpeq_epi32(_mm_and_si128(d, amask), zero);
+						__m128i alpha = _mm_or_si128(_mm_and_si128(clear, pa), _mm_andnot_si128(clear, amask));
+						__m128i res = _mm_or_si128(_mm_andnot_si128(amask, _mm_packus_epi16(lo, hi)), alpha);
+						_mm_storeu_si128((__m128i*)(dst + i), res);
+					}
+				}
+#endif
+			}
+			for (; i < count; i++)
+				dst[i] = BlendPixel(p, dst[i]);
+		}
+
+		/* BlendSpan: blend count pixels of src over dst */
+		static void BlendSpan(olc::Pixel* dst, const olc::Pixel* src, int count)
+		{
+			if (!kernels())
+			{
+				for (int i = 0; i < count; i++)
+					dst[i] = UI::TrueAlpha(0, 0, src[i], dst[i]);
+				return;
+			}
+			int i = 0;
+#if defined(RASPUTINUI_AVX2)
+			{
+				const __m256i zero = _mm256_setzero_si256();
+				const __m256i one = _mm256_set1_epi16(1);
+				const __m256i full = _mm256_set1_epi16(255);
+				const __m256i amask = _mm256_set1_epi32((int)0xFF000000);
+				const __m256i bothClear = _mm256_set1_epi32(1);
+				for (; i + 8 <= count; i += 8)
+				{
+					__m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+					__m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+					__m256i slo = _mm256_unpacklo_epi8(s, zero);
+					__m256i shi = _mm256_unpackhi_epi8(s, zero);
+					__m256i alo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(slo, 0xFF), 0xFF);
+					__m256i ahi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(shi, 0xFF), 0xFF);
+					__m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(slo, alo), _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), _mm256_sub_epi16(full, alo)));
+					__m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(shi, ahi), _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), _mm256_sub_epi16(full, ahi)));
+					lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(lo, one), _mm256_srli_epi16(lo, 8)), 8);
+					hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(hi, one), _mm256_srli_epi16(hi, 8)), 8);
+					__m256i dClear = _mm256_cmpeq_epi32(_mm256_and_si256(d, amask), zero);
+					__m256i sClear = _mm256_cmpeq_epi32(_mm256_and_si256(s, amask), zero);
+					__m256i kept = _mm256_or_si256(_mm256_and_si256(sClear, _mm256_and_si256(d, amask)), _mm256_andnot_si256(sClear, amask));
+					__m256i alpha = _mm256_or_si256(_mm256_and_si256(dClear, _mm256_and_si256(s, amask)), _mm256_andnot_si256(dClear, kept));
+					__m256i res = _mm256_or_si256(_mm256_andnot_si256(amask, _mm256_packus_epi16(lo, hi)), alpha);
+					__m256i both = _mm256_and_si256(dClear, sClear);
+					res = _mm256_or_si256(_mm256_and_si256(both, bothClear), _mm256_andnot_si256(both, res));
+					_mm256_storeu_si256((__m256i*)(dst + i), res);
+				}
+			}
+#endif
+#if defined(RASPUTINUI_SSE2)
+			{
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i one = _mm_set1_epi16(1);
+				const __m128i full = _mm_set1_epi16(255);
+				const __m128i amask = _mm_set1_epi32((int)0xFF000000);
+				const __m128i bothClear = _mm_set1_epi32(1);
+				for (; i + 4 <= count; i += 4)
+				{
+					__m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+					__m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+					__m128i slo = _mm_unpacklo_epi8(s, zero);
+					__m128i shi = _mm_unpackhi_epi8(s, zero);
+					__m128i alo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(slo, 0xFF), 0xFF);
+					__m128i ahi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(shi, 0xFF), 0xFF);
+					__m128i lo = _mm_add_epi16(_mm_mullo_epi16(slo, alo), _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(full, alo)));
+					__m128i hi = _mm_add_epi16(_mm_mullo_epi16(shi, ahi), _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(full, ahi)));
+					lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, one), _mm_srli_epi16(lo, 8)), 8);
+					hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, one), _mm_srli_epi16(hi, 8)), 8);
+					__m128i dClear = _mm_cmpeq_epi32(_mm_and_si128(d, amask), zero);
+					__m128i sClear = _mm_cmpeq_epi32(_mm_and_si128(s, amask), zero);
+					__m128i kept = _mm_or_si128(_mm_and_si128(sClear, _mm_and_si128(d, amask)), _mm_andnot_si128(sClear, amask));
+					__m128i alpha = _mm_or_si128(_mm_and_si128(dClear, _mm_and_si128(s, amask)), _mm_andnot_si128(dClear, kept));
+					__m128i res = _mm_or_si128(_mm_andnot_si128(amask, _mm_packus_epi16(lo, hi)), alpha);
+					__m128i both = _mm_and_si128(dClear, sClear);
+					res = _mm_or_si128(_mm_and_si128(both, bothClear), _mm_andnot_si128(both, res));
+					_mm_storeu_si128((__m128i*)(dst + i), res);
+				}
+			}
+#endif
+			for (; i < count; i++)
+				dst[i] = BlendPixel(src[i], dst[i]);
+		}
+
+		static void Clear(olc::Sprite* target, olc::Pixel p)
+		{
+			std::fill((uint32_t*)target->GetData(), (uint32_t*)target->GetData() + (target->width * target->height), p.n);
+		}
+
+		static void FillRect(olc::Sprite* target, olc::vi2d pos, olc::vi2d size, olc::Pixel p)
+		{
+			int x1 = std::max(0, pos.x);
+			int y1 = std::max(0, pos.y);
+			int x2 = std::min(target->width, pos.x + size.x);
+			int y2 = std::min(target->height, pos.y + size.y);
+			if (x2 <= x1)
+				return;
+			olc::Pixel* data = target->GetData();
+			for (int y = y1; y < y2; y++)
+				FillSpan(data + (y * target->width) + x1, x2 - x1, p);
+		}
+
+		/* DrawRect: like PixelGameEngine::DrawRect, the far edges are drawn at pos + size */
+		static void DrawRect(olc::Sprite* target, olc::vi2d pos, olc::vi2d size, olc::Pixel p)
+		{
+			FillRect(target, pos, { size.x + 1, 1 }, p);
+			FillRect(target, { pos.x, pos.y + size.y }, { size.x + 1, 1 }, p);
+			FillRect(target, { pos.x, pos.y + 1 }, { 1, size.y - 1 }, p);
+			FillRect(target, { pos.x + size.x, pos.y + 1 }, { 1, size.y - 1 }, p);
+		}
+
+		static void DrawPartialSprite(olc::Sprite* target, olc::vi2d pos, olc::Sprite* sprite, olc::vi2d sourcePos, olc::vi2d size, uint32_t scale)
+		{
+			if (sprite == NULL)
+				return;
+			int s = std::max(1, (int)scale);
+			int w = std::min(size.x, sprite->width - sourcePos.x);
+			int h = std::min(size.y, sprite->height - sourcePos.y);
+			olc::Pixel* data = target->GetData();
+			// the source columns that land on the target
+			int i1 = std::max(0, -pos.x / s);
+			int i2 = std::min(w, (target->width - pos.x + s - 1) / s);
+			if (i2 <= i1)
+				return;
+			for (int j = 0; j < h; j++)
+			{
+				const olc::Pixel* srow = sprite->GetData() + ((sourcePos.y + j) * sprite->width) + sourcePos.x;
+				for (int js = 0; js < s; js++)
+				{
+					int y = pos.y + (j * s) + js;
+					if (y < 0 || y >= target->height)
+						continue;
+					olc::Pixel* drow = data + (y * target->width);
+					if (s == 1)
+						BlendSpan(drow + pos.x + i1, srow + i1, i2 - i1);
+					else
+					{
+						for (int i = i1; i < i2; i++)
+						{
+							int x1 = std::max(0, pos.x + i * s);
+							int x2 = std::min(target->width, pos.x + (i + 1) * s);
+							FillSpan(drow + x1, x2 - x1, srow[i]);
+						}
+					}
+				}
+			}
+		}
+
+		/* FontMask: the pixels of a font sheet laid out like the olcPixelGameEngine font (16 columns of 8x8 glyphs, from ' '), a bit per pixel */
+		struct FontMask
+		{
+			uint8_t Rows[96][8] = {};
+			bool Valid = false;
+
+			void Build(olc::Sprite* font)
+			{
+				Valid = font != NULL;
+				for (int c = 0; c < 96 && Valid; c++)
+				{
+					for (int j = 0; j < 8; j++)
+					{
+						uint8_t bits = 0;
+						for (int i = 0; i < 8; i++)
+							if (font->GetPixel(((c % 16) * 8) + i, ((c / 16) * 8) + j).r > 0)
+								bits |= (uint8_t)(1 << i);
+						Rows[c][j] = bits;
+					}
+				}
+			}
 		};
 
-		/* MouseMove: The mouse moved. */
-		virtual void MouseMove()
+		/* DrawGlyphs: draw laid out text, from character first on, a span per run of lit pixels.  With no font the text only takes up space. */
+		static void DrawGlyphs(olc::Sprite* target, const FontMask& font, olc::vi2d pos, const TextLayout& layout, olc::Pixel col, uint32_t scale, size_t first = 0)
+		{
+			if (!font.Valid || first >= layout.CharPos.size())
+				return;
+			int s = std::max(1, (int)scale);
+			olc::vi2d origin = layout.CharPos[first];
+			olc::Pixel* data = target->GetData();
+			for (auto& glyph : layout.Glyphs)
+			{
+				if (glyph.Index < first)
+					continue;
+				int gx = pos.x + (glyph.Pos.x - origin.x) * s;
+				int gy = pos.y + (glyph.Pos.y - origin.y) * s;
+				if (gx >= target->width || gy >= target->height || gx + 8 * s <= 0 || gy + 8 * s <= 0)
+					continue;
+				const uint8_t* rows = font.Rows[glyph.C - 32];
+				for (int j = 0; j < 8; j++)
+				{
+					uint8_t bits = rows[j];
+					if (bits == 0)
+						continue;
+					for (int js = 0; js < s; js++)
+					{
+						int y = gy + (j * s) + js;
+						if (y < 0 || y >= target->height)
+							continue;
+						olc::Pixel* row = data + (y * target->width);
+						for (int i = 0; i < 8; )
+						{
+							if ((bits & (1 << i)) == 0)
+							{
+								i++;
+								continue;
+							}
+							int start = i;
+							while (i < 8 && (bits & (1 << i)) != 0)
+								i++;
+							int x1 = std::max(0, gx + start * s);
+							int x2 = std::min(target->width, gx + i * s);
+							if (x2 > x1)
+								FillSpan(row + x1, x2 - x1, col);
+						}
+					}
+				}
+			}
+		}
+
+		/* Modulate: a pixel multiplied by a tint, as a decal tint does */
+		static olc::Pixel Modulate(olc::Pixel p, olc::Pixel tint)
+		{
+			return olc::Pixel((uint8_t)((p.r * tint.r + 127) / 255), (uint8_t)((p.g * tint.g + 127) / 255), (uint8_t)((p.b * tint.b + 127) / 255), (uint8_t)((p.a * tint.a + 127) / 255));
+		}
+
+		/* Composite: draw part of a finished canvas over the target with ordinary alpha blending, like a decal is drawn, inside clip, multiplied by tint */
+		static void Composite(olc::Sprite* target, Rect clip, olc::vi2d pos, olc::Sprite* source, olc::vi2d sourcePos, olc::vi2d size, olc::Pixel tint = olc::WHITE)
+		{
+			if (source == NULL)
+				return;
+			int x1 = std::max(std::max(0, clip.Position.x), pos.x);
+			int y1 = std::max(std::max(0, clip.Position.y), pos.y);
+			int x2 = std::min(std::min(target->width, clip.right()), pos.x + std::min(size.x, source->width - sourcePos.x));
+			int y2 = std::min(std::min(target->height, clip.bottom()), pos.y + std::min(size.y, source->height - sourcePos.y));
+			for (int y = y1; y < y2; y++)
+			{
+				olc::Pixel* drow = target->GetData() + (y * target->width);
+				olc::Pixel* srow = source->GetData() + ((sourcePos.y + y - pos.y) * source->width) + (sourcePos.x - pos.x);
+				for (int x = x1; x < x2; x++)
+				{
+					olc::Pixel s = tint == olc::WHITE ? srow[x] : Modulate(srow[x], tint);
+					olc::Pixel& d = drow[x];
+					if (s.a == 255 || d.a == 0)
+						d = s;
+					else if (s.a != 0)
+					{
+						int c = 255 - s.a;
+						if (d.a == 255)
+							d = olc::Pixel((uint8_t)((s.r * s.a + d.r * c + 127) / 255), (uint8_t)((s.g * s.a + d.g * c + 127) / 255), (uint8_t)((s.b * s.a + d.b * c + 127) / 255), 255);
+						else
+						{
+							// over a transparent destination, keep the colors unpremultiplied
+							int da = (d.a * c + 127) / 255;
+							int a = s.a + da;
+							d = olc::Pixel((uint8_t)((s.r * s.a + d.r * da) / a), (uint8_t)((s.g * s.a + d.g * da) / a), (uint8_t)((s.b * s.a + d.b * da) / a), (uint8_t)a);
+						}
+					}
+				}
+			}
+		}
+
+		/* ClearRect: set an area of the target to p, without blending */
+		static void ClearRect(olc::Sprite* target, Rect area, olc::Pixel p)
+		{
+			int x1 = std::max(0, area.Position.x);
+			int y1 = std::max(0, area.Position.y);
+			int x2 = std::min(target->width, area.right());
+			int y2 = std::min(target->height, area.bottom());
+			for (int y = y1; y < y2; y++)
+				std::fill((uint32_t*)target->GetData() + (y * target->width) + x1, (uint32_t*)target->GetData() + (y * target->width) + x2, p.n);
+		}
+
+		/* div255: x / 255 rounded down, for x up to 255 * 255 */
+		static inline uint32_t div255(uint32_t x) { return (x + 1 + (x >> 8)) >> 8; }
+
+		/* kernels: wether the integer kernels can stand in for UI::TrueAlpha, otherwise it is called per pixel */
+		static bool kernels()
+		{
+#ifdef RASPUTINUI_NO_ALPHA
+			return false;
+#else
+			return UI::fBlendFactor == 1.0f;
+#endif
+		}
+
+	};
+
+	/* AtlasAllocator: packs rectangles into fixed size pages, on shelves (rows) of similar height.
+		Freed space is reused by anything that fits the shelf, and a shelf with nothing left on it is reset.
+		It only does the bookkeeping, whoever owns it creates the pages as PageCount grows. */
+	class AtlasAllocator
+	{
+	private:
+		struct Span { int x; int width; };
+		struct Shelf { int y; int height; int next; int live; std::vector<Span> free; };
+		struct Page { std::vector<Shelf> shelves; int top = 0; };
+		std::vector<Page> pages;
+
+		/* ShelfStep: shelf heights are rounded up to this, so similar sizes share shelves */
+		static const int ShelfStep = 4;
+
+		bool fitShelf(Shelf& shelf, int width, olc::vi2d& pos)
+		{
+			for (size_t i = 0; i < shelf.free.size(); i++)
+			{
+				Span& span = shelf.free[i];
+				if (span.width >= width)
+				{
+					pos = { span.x, shelf.y };
+					span.x += width;
+					span.width -= width;
+					if (span.width == 0)
+						shelf.free.erase(shelf.free.begin() + i);
+					return true;
+				}
+			}
+			if (PageSize.x - shelf.next >= width)
+			{
+				pos = { shelf.next, shelf.y };
+				shelf.next += width;
+				return true;
+			}
+			return false;
+		}
+
+	public:
+		olc::vi2d PageSize;
+
+		AtlasAllocator(olc::vi2d pageSize)
+		{
+			PageSize = pageSize;
+		}
+
+		size_t PageCount() { return pages.size(); }
+
+		/* Fits: wether something this size can be put in a page at all */
+		bool Fits(olc::vi2d size)
+		{
+			return size.x > 0 && size.y > 0 && size.x <= PageSize.x && size.y <= PageSize.y;
+		}
+
+		/* Allocate: find room for size, adding a page if none has any.  Returns false if it doesn't Fit. */
+		bool Allocate(olc::vi2d size, int& page, olc::vi2d& pos)
+		{
+			if (!Fits(size))
+				return false;
+			int height = std::min(PageSize.y, ((size.y + ShelfStep - 1) / ShelfStep) * ShelfStep);
+			for (size_t p = 0; p <= pages.size(); p++)
+			{
+				if (p == pages.size())
+					pages.push_back(Page());
+				Page& pg = pages[p];
+
+				// the shortest shelf it fits on, without wasting more than half its height
+				Shelf* best = NULL;
+				olc::vi2d bestPos;
+				for (auto& shelf : pg.shelves)
+				{
+					if (shelf.height < height || shelf.height > height + height / 2 + ShelfStep)
+						continue;
+					if (best != NULL && shelf.height >= best->height)
+						continue;
+					olc::vi2d at;
+					Shelf trial = shelf;
+					if (fitShelf(trial, size.x, at))
+					{
+						best = &shelf;
+						bestPos = at;
+					}
+				}
+				if (best != NULL)
+				{
+					fitShelf(*best, size.x, bestPos);
+					best->live++;
+					page = (int)p;
+					pos = bestPos;
+					return true;
+				}
+				if (PageSize.y - pg.top >= height)
+				{
+					pg.shelves.push_back({ pg.top, height, size.x, 1, {} });
+					pos = { 0, pg.top };
+					pg.top += height;
+					page = (int)p;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		/* Free: give back a rectangle from Allocate */
+		void Free(int page, olc::vi2d pos, olc::vi2d size)
+		{
+			if (page < 0 || page >= (int)pages.size())
+				return;
+			Page& pg = pages[page];
+			for (size_t i = 0; i < pg.shelves.size(); i++)
+			{
+				Shelf& shelf = pg.shelves[i];
+				if (shelf.y != pos.y)
+					continue;
+				if (--shelf.live == 0)
+				{
+					shelf.next = 0;
+					shelf.free.clear();
+					// empty shelves at the top of the page give their height back
+					while (!pg.shelves.empty() && pg.shelves.back().live == 0)
+					{
+						pg.top = pg.shelves.back().y;
+						pg.shelves.pop_back();
+					}
+					return;
+				}
+				if (pos.x + size.x == shelf.next)
+				{
+					shelf.next = pos.x;
+					while (!shelf.free.empty() && shelf.free.back().x + shelf.free.back().width == shelf.next)
+					{
+						shelf.next = shelf.free.back().x;
+						shelf.free.pop_back();
+					}
+					return;
+				}
+				// keep the free spans sorted, and merged with their neighbours
+				auto it = shelf.free.begin();
+				while (it != shelf.free.end() && it->x < pos.x)
+					++it;
+				it = shelf.free.insert(it, { pos.x, size.x });
+				if (it + 1 != shelf.free.end() && it->x + it->width == (it + 1)->x)
+				{
+					it->width += (it + 1)->width;
+					shelf.free.erase(it + 1);
+				}
+				if (it != shelf.free.begin() && (it - 1)->x + (it - 1)->width == it->x)
+				{
+					(it - 1)->width += it->width;
+					shelf.free.erase(it);
+				}
+				return;
+			}
+		}
+
+		void Clear() { pages.clear(); }
+	};
+
+	/* CanvasPool: keeps the sprites (and decals) of freed canvases for reuse, by size bucket.
+		Canvas storage is allocated at its bucket size, so a canvas that changes size a little is reused in place,
+		and one that changes a lot picks up a recycled buffer instead of going to the heap. */
+	class CanvasPool
+	{
+	private:
+		struct Entry { olc::Sprite* Sprite; olc::Decal* Decal; };
+		std::unordered_map<uint64_t, std::vector<Entry>> free;
+		size_t pooledPixels = 0;
+
+		static uint64_t key(int w, int h) { return ((uint64_t)(uint32_t)w << 32) | (uint32_t)h; }
+		static int bucket(int n)
+		{
+			int pow2 = 8;
+			while (pow2 < n)
+				pow2 <<= 1;
+			int step = std::max(8, pow2 / 8);
+			return std::max(step, ((n + step - 1) / step) * step);
+		}
+
+	public:
+		/* MaxPixels: the most pixels to hold on to, anything given back past this is deleted */
+		size_t MaxPixels = 4 * 1024 * 1024;
+
+		~CanvasPool() { Clear(); }
+
+		/* Bucket: the size canvas storage is really allocated at, each dimension rounded up to an eighth of its power of two */
+		static olc::vi2d Bucket(olc::vi2d size)
+		{
+			return { bucket(size.x), bucket(size.y) };
+		}
+
+		/* Take: a pooled sprite of exactly this bucket size, and its decal if it had one.  False if there isn't one. */
+		bool Take(olc::vi2d bucketSize, olc::Sprite*& sprite, olc::Decal*& decal)
+		{
+			auto it = free.find(key(bucketSize.x, bucketSize.y));
+			if (it == free.end() || it->second.empty())
+				return false;
+			sprite = it->second.back().Sprite;
+			decal = it->second.back().Decal;
+			it->second.pop_back();
+			pooledPixels -= (size_t)bucketSize.x * bucketSize.y;
+			return true;
+		}
+
+		/* Give: hand a sprite and its decal (or NULL) back for reuse, they are deleted if the pool is full */
+		void Give(olc::Sprite* sprite, olc::Decal* decal)
+		{
+			if (sprite == NULL)
+				return;
+			size_t pixels = (size_t)sprite->width * sprite->height;
+			if (pooledPixels + pixels > MaxPixels)
+			{
+				delete decal;
+				delete sprite;
+				return;
+			}
+			free[key(sprite->width, sprite->height)].push_back({ sprite, decal });
+			pooledPixels += pixels;
+		}
+
+		void Clear()
+		{
+			for (auto& bucket : free)
+			{
+				for (auto& entry : bucket.second)
+				{
+					delete entry.Decal;
+					delete entry.Sprite;
+				}
+			}
+			free.clear();
+			pooledPixels = 0;
+		}
+	};
+
+	/* DisplayList: the drawing of a canvas, recorded as a compact list of commands (clears, rects, bevels, text runs and sprite blits) to draw it again later.
+		Replaying one draws the same pixels without calling back into the control that recorded it, or laying anything out again.
+		Count, Bytes and Pixels tell you what drawing it costs, and Describe lists the commands, for profiling. */
+	class DisplayList
+	{
+	public:
+		struct Command
+		{
+			enum CommandType : uint8_t { Clear, FillRect, DrawRect, Bevel, Text, Sprite, PartialSprite };
+			CommandType Type;
+			/* Border: the border type of a Bevel */
+			uint8_t Border;
+			uint16_t Scale;
+			/* Index: the text run (Text) or sprite (Sprite, PartialSprite) drawn, and for Text, Size.x is the first character drawn */
+			uint32_t Index;
+			olc::vi2d Pos;
+			olc::vi2d Size;
+			olc::Pixel Color;
+		};
+
+		/* BackgroundChanges: the Changes of the control's background when this was recorded */
+		uint32_t BackgroundChanges = 0;
+
+		/* Reset: empty the list, to record a canvas of the given size.  Its storage is kept for the next recording. */
+		void Reset(olc::vi2d size)
+		{
+			commands.clear();
+			layouts.clear();
+			sprites.clear();
+			canvasSize = size;
+			pixels = 0;
+		}
+
+		/* Replay: draw the recorded commands with rb, onto the canvas it is drawing */
+		void Replay(RenderBackend* rb) const
+		{
+			for (const Command& c : commands)
+			{
+				switch (c.Type)
+				{
+				case Command::Clear: rb->Clear(c.Color); break;
+				case Command::FillRect: rb->FillRect(c.Pos, c.Size, c.Color); break;
+				case Command::DrawRect: rb->DrawRect(c.Pos, c.Size, c.Color); break;
+				case Command::Bevel: rb->DrawBevel((RUI::BorderType)c.Border, { c.Pos, c.Size }); break;
+				case Command::Text: rb->DrawTextLayout(c.Pos, *layouts[c.Index], c.Color, c.Scale, (size_t)c.Size.x); break;
+				case Command::Sprite: rb->DrawSprite(c.Pos, sprites[c.Index].Sprite, c.Scale); break;
+				case Command::PartialSprite: rb->DrawPartialSprite(c.Pos, sprites[c.Index].Sprite, sprites[c.Index].Source, c.Size, c.Scale); break;
+				}
+			}
+		}
+
+		/* Rasterize: draw the recorded commands straight onto target with Raster, the way the software and engine backends draw them.
+			It only reads the list, so lists can be rasterized on several threads at once, each onto its own target. */
+		void Rasterize(olc::Sprite* target, const Raster::FontMask& font) const
+		{
+			for (const Command& c : commands)
+			{
+				switch (c.Type)
+				{
+				case Command::Clear: Raster::Clear(target, c.Color); break;
+				case Command::FillRect: Raster::FillRect(target, c.Pos, c.Size, c.Color); break;
+				case Command::DrawRect: Raster::DrawRect(target, c.Pos, c.Size, c.Color); break;
+				case Command::Bevel:
+					UI::BevelRects((RUI::BorderType)c.Border, { c.Pos, c.Size },
+						[target](olc::vi2d pos, olc::vi2d size, olc::Pixel p) { Raster::FillRect(target, pos, size, p); },
+						[target](olc::vi2d pos, olc::vi2d size, olc::Pixel p) { Raster::DrawRect(target, pos, size, p); });
+					break;
+				case Command::Text: Raster::DrawGlyphs(target, font, c.Pos, *layouts[c.Index], c.Color, c.Scale, (size_t)c.Size.x); break;
+				case Command::Sprite: Raster::DrawPartialSprite(target, c.Pos, sprites[c.Index].Sprite, { 0,0 }, c.Size, c.Scale); break;
+				case Command::PartialSprite: Raster::DrawPartialSprite(target, c.Pos, sprites[c.Index].Sprite, sprites[c.Index].Source, c.Size, c.Scale); break;
+				}
+			}
+		}
+
+		/* CanvasSize: the size of the canvas it was recorded for */
+		olc::vi2d CanvasSize() const { return canvasSize; }
+		/* Count: the number of commands */
+		size_t Count() const { return commands.size(); }
+		const std::vector<Command>& Commands() const { return commands; }
+		/* Bytes: the memory the recording uses, not counting text layouts it shares */
+		size_t Bytes() const
+		{
+			return sizeof(DisplayList) + commands.capacity() * sizeof(Command) + layouts.capacity() * sizeof(layouts[0]) + sprites.capacity() * sizeof(SpriteSource);
+		}
+		/* Pixels: roughly how many pixels replaying it touches, the cost of drawing it */
+		uint64_t Pixels() const { return pixels; }
+
+		/* Describe: the commands, one a line, for looking at what a control draws */
+		std::string Describe() const
+		{
+			static const char* names[] = { "clear", "fill-rect", "draw-rect", "bevel", "text", "sprite", "partial-sprite" };
+			std::string result;
+			char line[160];
+			for (const Command& c : commands)
+			{
+				snprintf(line, sizeof(line), "%-14s pos %d,%d size %d,%d color %02x%02x%02x%02x scale %u", names[c.Type], c.Pos.x, c.Pos.y, c.Size.x, c.Size.y, c.Color.r, c.Color.g, c.Color.b, c.Color.a, (unsigned)c.Scale);
+				result += line;
+				if (c.Type == Command::Text)
+					result += " \"" + layouts[c.Index]->Text.substr((size_t)c.Size.x) + "\"";
+				result += "\n";
+			}
+			return result;
+		}
+
+	private:
+		friend class DisplayListRecorder;
+		struct SpriteSource
+		{
+			olc::Sprite* Sprite;
+			olc::vi2d Source;
+		};
+
+		std::vector<Command> commands;
+		std::vector<std::shared_ptr<const TextLayout>> layouts;
+		std::vector<SpriteSource> sprites;
+		olc::vi2d canvasSize = { 0,0 };
+		uint64_t pixels = 0;
+
+		void add(Command::CommandType type, olc::vi2d pos, olc::vi2d size, olc::Pixel color, uint32_t scale = 1, uint32_t index = 0, uint8_t border = 0)
+		{
+			commands.push_back({ type, border, (uint16_t)scale, index, pos, size, color });
+		}
+	};
+
+	/* PGEBackend: the default backend, draws canvases with olcPixelGameEngine and composites them as decals.
+		Canvases up to AtlasMaxSize are packed into shared atlas pages, and the frame is sent to the engine as one
+		polygon decal per run of canvases on the same page.  Dirty pages are uploaded once, at the end of the frame.
+		Uploading a page uploads all of it, so a canvas redrawn often (a hovered row, an animation) is moved to a texture of its own.
+		Define RASPUTINUI_NO_DECAL_BATCH for engines without DecalStructure::LIST, to draw a partial decal per canvas instead. */
+	class PGEBackend : public RenderBackend
+	{
+	private:
+		olc::PixelGameEngine* pge;
+		olc::Sprite* prevTarget = NULL;
+		olc::Pixel::Mode prevMode = olc::Pixel::NORMAL;
+		Canvas* compositeTarget = NULL;
+		Rect compositeArea;
+
+		struct AtlasPage { olc::Sprite* Sprite; olc::Decal* Decal; bool Dirty; };
+		AtlasAllocator atlas;
+		std::vector<AtlasPage> pages;
+
+		/* target: the sprite being drawn, between BeginCanvas and EndCanvas */
+		olc::Sprite* target = NULL;
+
+		/* font: the engine's font, read back by drawing every character once */
+		Raster::FontMask font;
+
+		void buildFont()
+		{
+			olc::Sprite sheet(128, 48);
+			olc::Sprite* prev = pge->GetDrawTarget();
+			olc::Pixel::Mode mode = pge->GetPixelMode();
+			pge->SetDrawTarget(&sheet);
+			pge->SetPixelMode(olc::Pixel::NORMAL);
+			pge->Clear(olc::BLANK);
+			for (int c = 32; c < 128; c++)
+				pge->DrawString({ ((c - 32) % 16) * 8, ((c - 32) / 16) * 8 }, std::string(1, (char)c), olc::WHITE);
+			pge->SetPixelMode(mode);
+			pge->SetDrawTarget(prev);
+			font.Build(&sheet);
+		}
+
+		/* scratch: atlas canvases are drawn here, then copied into their page.  Taken from scratchPool by size, so it needs no decal. */
+		olc::Sprite* scratch = NULL;
+		CanvasPool scratchPool;
+		CanvasPool pool;
+		/* workerScratch: the scratchPool of each worker of RasterizeCanvas */
+		std::deque<CanvasPool> workerScratch;
+
+		/* frame: counts BeginFrame, to tell how soon a canvas is redrawn */
+		uint64_t frame = 0;
+
+		/* redrawnOften: count a redraw of a canvas, true once it has been redrawn AtlasHotRedraws times running, each within AtlasHotFrames of the last */
+		bool redrawnOften(Canvas& canvas)
+		{
+			if (canvas.Redraws > 0 && frame - canvas.RedrawFrame <= (uint64_t)AtlasHotFrames)
+				canvas.Redraws++;
+			else
+				canvas.Redraws = 1;
+			canvas.RedrawFrame = frame;
+			return canvas.Redraws >= AtlasHotRedraws;
+		}
+
+		/* moveOffAtlas: give an atlas canvas a pooled texture of its own, so redrawing it no longer uploads its whole page.  keep copies its pixels over. */
+		void moveOffAtlas(Canvas& canvas, bool keep)
+		{
+			olc::vi2d bucket = CanvasPool::Bucket(canvas.Size);
+			olc::Sprite* sprite;
+			olc::Decal* decal;
+			if (!pool.Take(bucket, sprite, decal))
+			{
+				sprite = new olc::Sprite(bucket.x, bucket.y);
+				decal = new olc::Decal(sprite);
+			}
+			if (keep)
+			{
+				for (int y = 0; y < canvas.Size.y; y++)
+				{
+					olc::Pixel* row = canvas.Sprite->GetData() + (canvas.Offset.y + y) * canvas.Sprite->width + canvas.Offset.x;
+					std::copy(row, row + canvas.Size.x, sprite->GetData() + y * sprite->width);
+				}
+			}
+			atlas.Free(canvas.Page, canvas.Offset, canvas.Size);
+			canvas.Sprite = sprite;
+			canvas.Decal = decal;
+			canvas.Page = -1;
+			canvas.Offset = { 0,0 };
+		}
+
+		/* copyToPage: copy an atlas canvas drawn in from into its place on its page */
+		static void copyToPage(Canvas& canvas, olc::Sprite* from)
+		{
+			for (int y = 0; y < canvas.Size.y; y++)
+				std::copy(from->GetData() + y * from->width, from->GetData() + y * from->width + canvas.Size.x,
+					canvas.Sprite->GetData() + (canvas.Offset.y + y) * canvas.Sprite->width + canvas.Offset.x);
+		}
+
+		struct DecalQuad { olc::vf2d Pos; olc::vf2d SourcePos; olc::vf2d Size; olc::Pixel Color; };
+		struct DecalBatch { olc::Decal* Decal; olc::Pixel Tint; Rect Bounds; std::vector<DecalQuad> Quads; };
+		/* batches: this frame's canvas draws, grouped by decal and tint, and DrawQuads in batches with no decal.  Kept between frames so they stop allocating. */
+		std::vector<DecalBatch> batches;
+		size_t batchCount = 0;
+		std::vector<olc::vf2d> vertPos;
+		std::vector<olc::vf2d> vertUV;
+
+		/* BatchLookback: how many batches back a draw can join one with the same decal, if it doesn't overlap anything in between */
+		static const size_t BatchLookback = 8;
+
+		/* queueDraw: a canvas draw, tinted by color, or a DrawQuad of color with no decal */
+		void queueDraw(olc::Decal* decal, olc::vf2d pos, olc::vf2d sourcePos, olc::vf2d size, olc::Pixel color = olc::WHITE)
+		{
+			Rect area = { { (int)pos.x, (int)pos.y }, { (int)size.x + 1, (int)size.y + 1 } };
+			olc::Pixel tint = decal != NULL ? color : olc::WHITE; // quads each keep their own color
+			DecalBatch* batch = NULL;
+			for (size_t i = batchCount; i > 0 && batchCount - i < BatchLookback; i--)
+			{
+				if (batches[i - 1].Decal == decal && batches[i - 1].Tint == tint)
+				{
+					batch = &batches[i - 1];
+					break;
+				}
+				if (batches[i - 1].Bounds.Intersects(area))
+					break; // drawing any earlier would put us under this
+			}
+			if (batch == NULL)
+			{
+				if (batchCount == batches.size())
+					batches.push_back(DecalBatch());
+				batch = &batches[batchCount++];
+				batch->Decal = decal;
+				batch->Tint = tint;
+				batch->Bounds = area;
+				batch->Quads.clear();
+			}
+			else
+				batch->Bounds = batch->Bounds.Union(area);
+			batch->Quads.push_back({ pos, sourcePos, size, color });
+		}
+
+		void flushBatches()
+		{
+			for (size_t b = 0; b < batchCount; b++)
+			{
+				DecalBatch& batch = batches[b];
+				if (batch.Decal == NULL)
+				{
+					for (auto& q : batch.Quads)
+						pge->FillRectDecal(q.Pos, q.Size, q.Color);
+					Batches++;
+					continue;
+				}
+#ifndef RASPUTINUI_NO_DECAL_BATCH
+				if (batch.Quads.size() > 1)
+				{
+					olc::vf2d texel = { 1.0f / batch.Decal->sprite->width, 1.0f / batch.Decal->sprite->height };
+					vertPos.clear();
+					vertUV.clear();
+					for (auto& q : batch.Quads)
+					{
+						olc::vf2d p[4] = { q.Pos, { q.Pos.x, q.Pos.y + q.Size.y }, q.Pos + q.Size, { q.Pos.x + q.Size.x, q.Pos.y } };
+						olc::vf2d uv[4] = { q.SourcePos * texel, olc::vf2d(q.SourcePos.x, q.SourcePos.y + q.Size.y) * texel, (q.SourcePos + q.Size) * texel, olc::vf2d(q.SourcePos.x + q.Size.x, q.SourcePos.y) * texel };
+						const int tris[6] = { 0,1,2, 0,2,3 };
+						for (int i : tris)
+						{
+							vertPos.push_back(p[i]);
+							vertUV.push_back(uv[i]);
+						}
+					}
+					pge->SetDecalStructure(olc::DecalStructure::LIST);
+					pge->DrawPolygonDecal(batch.Decal, vertPos, vertUV, batch.Tint);
+					pge->SetDecalStructure(olc::DecalStructure::FAN);
+					Batches++;
+					continue;
+				}
+#endif
+				for (auto& q : batch.Quads)
+				{
+					pge->DrawPartialDecal(q.Pos, batch.Decal, q.SourcePos, q.Size, { 1.0f,1.0f }, batch.Tint);
+					Batches++;
+				}
+			}
+			batchCount = 0;
+		}
+
+	public:
+		/* AtlasMaxSize: canvases bigger than this in either direction get a texture of their own */
+		olc::vi2d AtlasMaxSize = { 128,128 };
+		/* AtlasHotRedraws, AtlasHotFrames: an atlas canvas redrawn AtlasHotRedraws times running, each within AtlasHotFrames frames of the last, moves to a texture of its own */
+		int AtlasHotRedraws = 4;
+		int AtlasHotFrames = 30;
+
+		/* Batches: decal draws sent to the engine last frame */
+		int Batches = 0;
+
+		PGEBackend(olc::PixelGameEngine* engine, olc::vi2d atlasPageSize = { 512,512 })
+			: atlas(atlasPageSize)
+		{
+			pge = engine;
+		}
+
+		~PGEBackend()
+		{
+			for (auto& page : pages)
+			{
+				delete page.Decal;
+				delete page.Sprite;
+			}
+		}
+
+		/* AtlasPages: the number of atlas textures in use */
+		size_t AtlasPages() { return pages.size(); }
+
+		olc::vi2d ScreenSize() override { return { pge->ScreenWidth(), pge->ScreenHeight() }; }
+
+		void BeginFrame() override
+		{
+			Batches = 0;
+			batchCount = 0;
+			frame++;
+		}
+
+		void EndFrame() override
+		{
+			for (auto& page : pages)
+			{
+				if (page.Dirty)
+				{
+					page.Decal->Update();
+					page.Dirty = false;
+				}
+			}
+			flushBatches();
+		}
+
+		void CreateCanvas(Canvas& canvas, olc::vi2d size) override
+		{
+			olc::vi2d bucket = CanvasPool::Bucket(size);
+			int redraws = canvas.Redraws;
+			uint64_t redrawFrame = canvas.RedrawFrame;
+			bool hot = redraws >= AtlasHotRedraws && frame - redrawFrame <= (uint64_t)AtlasHotFrames;
+			bool atlased = size.x <= AtlasMaxSize.x && size.y <= AtlasMaxSize.y && !hot; // a canvas still being redrawn often stays off the atlas
+			if (canvas.Sprite != NULL && canvas.Page < 0 && !atlased && canvas.Sprite->width == bucket.x && canvas.Sprite->height == bucket.y)
+			{
+				canvas.Size = size; // still the same bucket, reuse it in place
+				return;
+			}
+			FreeCanvas(canvas);
+			canvas.Owner = this;
+			canvas.Size = size;
+			canvas.Redraws = redraws;
+			canvas.RedrawFrame = redrawFrame;
+			if (atlased && size.y <= AtlasMaxSize.y && atlas.Allocate(size, canvas.Page, canvas.Offset))
+			{
+				while (pages.size() < atlas.PageCount())
+				{
+					olc::Sprite* sprite = new olc::Sprite(atlas.PageSize.x, atlas.PageSize.y);
+					pages.push_back({ sprite, new olc::Decal(sprite), false });
+				}
+				canvas.Sprite = pages[canvas.Page].Sprite;
+				canvas.Decal = pages[canvas.Page].Decal;
+			}
+			else if (!pool.Take(bucket, canvas.Sprite, canvas.Decal))
+			{
+				canvas.Sprite = new olc::Sprite(bucket.x, bucket.y);
+				canvas.Decal = new olc::Decal(canvas.Sprite);
+			}
+		}
+
+		void FreeCanvas(Canvas& canvas) override
+		{
+			if (canvas.Page >= 0)
+				atlas.Free(canvas.Page, canvas.Offset, canvas.Size);
+			else
+				pool.Give(canvas.Sprite, canvas.Decal);
+			canvas = Canvas();
+		}
+
+		void BeginCanvas(Canvas& canvas) override
+		{
+			prevTarget = pge->GetDrawTarget();
+			prevMode = pge->GetPixelMode();
+			if (redrawnOften(canvas) && canvas.Page >= 0)
+				moveOffAtlas(canvas, false); // it is about to be drawn from scratch
+			if (canvas.Page >= 0)
+			{
+				olc::vi2d bucket = CanvasPool::Bucket(canvas.Size);
+				olc::Decal* none;
+				if (!scratchPool.Take(bucket, scratch, none))
+					scratch = new olc::Sprite(bucket.x, bucket.y);
+				target = scratch;
+			}
+			else
+				target = canvas.Sprite;
+			pge->SetDrawTarget(target);
+			//pge->SetPixelMode(olc::Pixel::ALPHA);
+			pge->SetPixelMode(UI::TrueAlpha); // for a control with RecordDrawing off that draws with the engine itself
+		}
+
+		void EndCanvas(Canvas& canvas) override
+		{
+			if (canvas.Page >= 0)
+			{
+				copyToPage(canvas, scratch);
+				pages[canvas.Page].Dirty = true;
+				scratchPool.Give(scratch, NULL);
+				scratch = NULL;
+			}
+			else
+				canvas.Decal->Update();
+			target = NULL;
+			pge->SetPixelMode(prevMode);
+			pge->SetDrawTarget(prevTarget);
+		}
+
+		// fills and blits use the blend kernels directly, rather than the engine calling TrueAlpha for every pixel
+		void Clear(olc::Pixel p) override { Raster::Clear(target, p); }
+		void FillRect(olc::vi2d pos, olc::vi2d size, olc::Pixel p) override { Raster::FillRect(target, pos, size, p); }
+		void DrawRect(olc::vi2d pos, olc::vi2d size, olc::Pixel p) override { Raster::DrawRect(target, pos, size, p); }
+		void DrawString(olc::vi2d pos, const std::string& text, olc::Pixel p, uint32_t scale) override { DrawTextLayout(pos, *LayoutText(text), p, scale); }
+		olc::vi2d GetTextSize(const std::string& text) override { return LayoutText(text)->Size; }
+
+		void DrawTextLayout(olc::vi2d pos, const TextLayout& layout, olc::Pixel p, uint32_t scale, size_t first = 0) override
+		{
+			if (!font.Valid)
+				buildFont();
+			Raster::DrawGlyphs(target, font, pos, layout, p, scale, first);
+		}
+		void DrawSprite(olc::vi2d pos, olc::Sprite* sprite, uint32_t scale) override { Raster::DrawPartialSprite(target, pos, sprite, { 0,0 }, { sprite->width, sprite->height }, scale); }
+		void DrawPartialSprite(olc::vi2d pos, olc::Sprite* sprite, olc::vi2d sourcePos, olc::vi2d size, uint32_t scale) override { Raster::DrawPartialSprite(target, pos, sprite, sourcePos, size, scale); }
+
+		void DrawCanvas(Canvas& canvas, olc::vf2d pos, olc::Pixel tint = olc::WHITE) override
+		{
+			DrawPartialCanvas(canvas, pos, { 0,0 }, canvas.Size, tint);
+		}
+
+		void DrawPartialCanvas(Canvas& canvas, olc::vf2d pos, olc::vf2d sourcePos, olc::vf2d sourceSize, olc::Pixel tint = olc::WHITE) override
+		{
+			if (compositeTarget != NULL)
+			{
+				olc::vi2d offset = compositeTarget->Offset; // the target may sit on an atlas page
+				Raster::Composite(compositeTarget->Sprite, Rect(compositeArea.Position + offset, compositeArea.Size), olc::vi2d(pos) + offset, canvas.Sprite, { canvas.Offset.x + (int)sourcePos.x, canvas.Offset.y + (int)sourcePos.y }, sourceSize, tint);
+			}
+			else
+				queueDraw(canvas.Decal, pos, { canvas.Offset.x + sourcePos.x, canvas.Offset.y + sourcePos.y }, sourceSize, tint);
+		}
+
+		void DrawQuad(olc::vi2d pos, olc::vi2d size, olc::Pixel p) override
+		{
+			if (compositeTarget != NULL)
+			{
+				Rect area = Rect(pos, size).Intersection(compositeArea);
+				Raster::FillRect(compositeTarget->Sprite, area.Position + compositeTarget->Offset, area.Size, p);
+			}
+			else
+				queueDraw(NULL, pos, { 0,0 }, size, p);
+		}
+
+		void BeginComposite(Canvas& target, Rect area) override
+		{
+			compositeTarget = &target;
+			compositeArea = area;
+			Raster::ClearRect(target.Sprite, Rect(area.Position + target.Offset, area.Size), olc::BLANK);
+		}
+
+		void EndComposite(Canvas& target) override
+		{
+			compositeTarget = NULL;
+			if (target.Page >= 0)
+				pages[target.Page].Dirty = true;
+			else
+				target.Decal->Update();
+		}
+		bool PrepareRasterize(size_t workers) override
+		{
+			if (!font.Valid)
+				buildFont(); // it draws with the engine, so only here
+			while (workerScratch.size() < workers)
+				workerScratch.emplace_back();
+			return true;
+		}
+
+		/* RasterizeCanvas: atlas canvases are drawn on the worker's own scratch, then copied into their page, which no other canvas overlaps */
+		void RasterizeCanvas(Canvas& canvas, const DisplayList& list, size_t worker) override
+		{
+			olc::Sprite* target = canvas.Sprite;
+			if (canvas.Page >= 0)
+			{
+				olc::vi2d bucket = CanvasPool::Bucket(canvas.Size);
+				olc::Decal* none;
+				if (!workerScratch[worker].Take(bucket, target, none))
+					target = new olc::Sprite(bucket.x, bucket.y);
+			}
+			Raster::Clear(target, olc::BLANK);
+			list.Rasterize(target, font);
+			if (canvas.Page >= 0)
+			{
+				copyToPage(canvas, target);
+				workerScratch[worker].Give(target, NULL);
+			}
+		}
+
+		void FinishCanvas(Canvas& canvas, const DisplayList& list) override
+		{
+			if (redrawnOften(canvas) && canvas.Page >= 0)
+				moveOffAtlas(canvas, true); // already drawn on its page, by a worker
+			if (canvas.Page >= 0)
+				pages[canvas.Page].Dirty = true;
+			else
+				canvas.Decal->Update();
+		}
+	};
+
+	/* SoftwareBackend: a pure CPU backend that composites the UI into Framebuffer, so it can run in a process with no window or GL context.
+		Font should be a font sheet laid out like the olcPixelGameEngine font (pge->GetFontSprite() if an engine is available).  Without one, text is measured but not drawn. */
+	class SoftwareBackend : public RenderBackend
+	{
+	private:
+		olc::Sprite* target = NULL;
+		Canvas* compositeTarget = NULL;
+		Rect compositeArea;
+		CanvasPool pool;
+		Raster::FontMask font;
+		olc::Sprite* fontSource = NULL;
+	public:
+		/* Framebuffer: the composited UI, after EndFrame */
+		olc::Sprite* Framebuffer;
+		olc::Sprite* Font;
+		/* ClearColor: what the framebuffer is cleared to at the start of each frame */
+		olc::Pixel ClearColor = olc::BLACK;
+
+		SoftwareBackend(olc::vi2d screenSize, olc::Sprite* font = NULL)
+		{
+			Framebuffer = new olc::Sprite(screenSize.x, screenSize.y);
+			Font = font;
+		}
+
+		~SoftwareBackend()
+		{
+			delete Framebuffer;
+		}
+
+		olc::vi2d ScreenSize() override { return { Framebuffer->width, Framebuffer->height }; }
+
+		void BeginFrame() override { Raster::Clear(Framebuffer, ClearColor); }
+
+		void CreateCanvas(Canvas& canvas, olc::vi2d size) override
+		{
+			olc::vi2d bucket = CanvasPool::Bucket(size);
+			if (canvas.Sprite != NULL && canvas.Sprite->width == bucket.x && canvas.Sprite->height == bucket.y)
+			{
+				canvas.Size = size; // still the same bucket, reuse it in place
+				return;
+			}
+			FreeCanvas(canvas);
+			canvas.Owner = this;
+			canvas.Size = size;
+			olc::Decal* none;
+			if (!pool.Take(bucket, canvas.Sprite, none))
+				canvas.Sprite = new olc::Sprite(bucket.x, bucket.y);
+		}
+
+		void FreeCanvas(Canvas& canvas) override
+		{
+			pool.Give(canvas.Sprite, NULL);
+			canvas = Canvas();
+		}
+
+		void BeginCanvas(Canvas& canvas) override { target = canvas.Sprite; }
+		void EndCanvas(Canvas& canvas) override { target = NULL; }
+
+		void Clear(olc::Pixel p) override { Raster::Clear(target, p); }
+		void FillRect(olc::vi2d pos, olc::vi2d size, olc::Pixel p) override { Raster::FillRect(target, pos, size, p); }
+		void DrawRect(olc::vi2d pos, olc::vi2d size, olc::Pixel p) override { Raster::DrawRect(target, pos, size, p); }
+		void DrawString(olc::vi2d pos, const std::string& text, olc::Pixel p, uint32_t scale) override { DrawTextLayout(pos, *LayoutText(text), p, scale); }
+		olc::vi2d GetTextSize(const std::string& text) override { return LayoutText(text)->Size; }
+
+		void DrawTextLayout(olc::vi2d pos, const TextLayout& layout, olc::Pixel p, uint32_t scale, size_t first = 0) override
+		{
+			if (fontSource != Font)
+			{
+				fontSource = Font;
+				font.Build(Font);
+			}
+			Raster::DrawGlyphs(target, font, pos, layout, p, scale, first);
+		}
+		void DrawSprite(olc::vi2d pos, olc::Sprite* sprite, uint32_t scale) override { Raster::DrawPartialSprite(target, pos, sprite, { 0,0 }, { sprite->width, sprite->height }, scale); }
+		void DrawPartialSprite(olc::vi2d pos, olc::Sprite* sprite, olc::vi2d sourcePos, olc::vi2d size, uint32_t scale) override { Raster::DrawPartialSprite(target, pos, sprite, sourcePos, size, scale); }
+
+		void DrawCanvas(Canvas& canvas, olc::vf2d pos, olc::Pixel tint = olc::WHITE) override
+		{
+			if (compositeTarget != NULL)
+				Raster::Composite(compositeTarget->Sprite, compositeArea, pos, canvas.Sprite, { 0,0 }, canvas.Size, tint);
+			else
+				Raster::Composite(Framebuffer, { {0,0}, ScreenSize() }, pos, canvas.Sprite, { 0,0 }, canvas.Size, tint);
+		}
+
+		void DrawPartialCanvas(Canvas& canvas, olc::vf2d pos, olc::vf2d sourcePos, olc::vf2d sourceSize, olc::Pixel tint = olc::WHITE) override
+		{
+			if (compositeTarget != NULL)
+				Raster::Composite(compositeTarget->Sprite, compositeArea, pos, canvas.Sprite, sourcePos, sourceSize, tint);
+			else
+				Raster::Composite(Framebuffer, { {0,0}, ScreenSize() }, pos, canvas.Sprite, sourcePos, sourceSize, tint);
+		}
+
+		void DrawQuad(olc::vi2d pos, olc::vi2d size, olc::Pixel p) override
+		{
+			if (compositeTarget != NULL)
+			{
+				Rect area = Rect(pos, size).Intersection(compositeArea);
+				Raster::FillRect(compositeTarget->Sprite, area.Position, area.Size, p);
+			}
+			else
+				Raster::FillRect(Framebuffer, pos, size, p);
+		}
+
+		void BeginComposite(Canvas& target, Rect area) override
+		{
+			compositeTarget = &target;
+			compositeArea = area;
+			Raster::ClearRect(target.Sprite, area, olc::BLANK);
+		}
+
+		void EndComposite(Canvas& target) override { compositeTarget = NULL; }
+		bool PrepareRasterize(size_t workers) override
+		{
+			if (fontSource != Font)
+			{
+				fontSource = Font;
+				font.Build(Font);
+			}
+			return true;
+		}
+
+		void RasterizeCanvas(Canvas& canvas, const DisplayList& list, size_t worker) override
+		{
+			Raster::Clear(canvas.Sprite, olc::BLANK);
+			list.Rasterize(canvas.Sprite, font);
+		}
+	};
+
+	/* RenderStats: counters kept by RecordingBackend */
+	struct RenderStats
+	{
+		/* DrawCalls: canvases composited onto the screen */
+		uint64_t DrawCalls = 0;
+		/* RasterCalls: clear, rect, text and sprite calls made while drawing canvases */
+		uint64_t RasterCalls = 0;
+		/* TextureUploads: canvases finished (and uploaded, on a GPU backend) */
+		uint64_t TextureUploads = 0;
+		uint64_t UploadedPixels = 0;
+		/* CanvasCreates: canvases (re)allocated */
+		uint64_t CanvasCreates = 0;
+		/* CompositedPixels: the area recomposited by damage tracking */
+		uint64_t CompositedPixels = 0;
+	};
+
+	/* RecordingBackend: counts the work the UI asks for, and passes it on to another backend.
+		With no inner backend nothing is drawn at all, which is useful to measure the cost of the UI itself. */
+	class RecordingBackend : public RenderBackend
+	{
+	private:
+		RenderBackend* inner;
+		olc::vi2d screenSize;
+	public:
+		/* Frame: counts for the current (or last finished) frame */
+		RenderStats Frame;
+		/* Total: counts since the backend was created */
+		RenderStats Total;
+		uint64_t Frames = 0;
+
+		RecordingBackend(RenderBackend* innerBackend)
+		{
+			inner = innerBackend;
+			screenSize = inner->ScreenSize();
+		}
+
+		RecordingBackend(olc::vi2d size)
+		{
+			inner = NULL;
+			screenSize = size;
+		}
+
+		olc::vi2d ScreenSize() override { return screenSize; }
+
+		void BeginFrame() override
+		{
+			Frame = RenderStats();
+			if (inner) inner->BeginFrame();
+		}
+
+		void EndFrame() override
+		{
+			Frames++;
+			Total.DrawCalls += Frame.DrawCalls;
+			Total.RasterCalls += Frame.RasterCalls;
+			Total.TextureUploads += Frame.TextureUploads;
+			Total.UploadedPixels += Frame.UploadedPixels;
+			Total.CanvasCreates += Frame.CanvasCreates;
+			Total.CompositedPixels += Frame.CompositedPixels;
+			if (inner) inner->EndFrame();
+		}
+
+		void CreateCanvas(Canvas& canvas, olc::vi2d size) override
+		{
+			Frame.CanvasCreates++;
+			if (inner)
+				inner->CreateCanvas(canvas, size);
+			else
+				canvas.Size = size;
+			canvas.Owner = this; // so the canvas comes back through here to be freed
+		}
+
+		void FreeCanvas(Canvas& canvas) override
+		{
+			if (inner) inner->FreeCanvas(canvas);
+			canvas = Canvas();
+		}
+
+		void BeginCanvas(Canvas& canvas) override { if (inner) inner->BeginCanvas(canvas); }
+
+		void EndCanvas(Canvas& canvas) override
+		{
+			Frame.TextureUploads++;
+			Frame.UploadedPixels += (uint64_t)canvas.Size.x * canvas.Size.y;
+			if (inner) inner->EndCanvas(canvas);
+		}
+
+		void Clear(olc::Pixel p) override { Frame.RasterCalls++; if (inner) inner->Clear(p); }
+		void FillRect(olc::vi2d pos, olc::vi2d size, olc::Pixel p) override { Frame.RasterCalls++; if (inner) inner->FillRect(pos, size, p); }
+		void DrawRect(olc::vi2d pos, olc::vi2d size, olc::Pixel p) override { Frame.RasterCalls++; if (inner) inner->DrawRect(pos, size, p); }
+		void DrawString(olc::vi2d pos, const std::string& text, olc::Pixel p, uint32_t scale) override { Frame.RasterCalls++; if (inner) inner->DrawString(pos, text, p, scale); }
+		olc::vi2d GetTextSize(const std::string& text) override { return inner ? inner->GetTextSize(text) : LayoutText(text)->Size; }
+		void DrawTextLayout(olc::vi2d pos, const TextLayout& layout, olc::Pixel p, uint32_t scale, size_t first = 0) override { Frame.RasterCalls++; if (inner) inner->DrawTextLayout(pos, layout, p, scale, first); }
+		void DrawSprite(olc::vi2d pos, olc::Sprite* sprite, uint32_t scale) override { Frame.RasterCalls++; if (inner) inner->DrawSprite(pos, sprite, scale); }
+		void DrawPartialSprite(olc::vi2d pos, olc::Sprite* sprite, olc::vi2d sourcePos, olc::vi2d size, uint32_t scale) override { Frame.RasterCalls++; if (inner) inner->DrawPartialSprite(pos, sprite, sourcePos, size, scale); }
+
+		void DrawCanvas(Canvas& canvas, olc::vf2d pos, olc::Pixel tint = olc::WHITE) override { Frame.DrawCalls++; if (inner) inner->DrawCanvas(canvas, pos, tint); }
+		void DrawPartialCanvas(Canvas& canvas, olc::vf2d pos, olc::vf2d sourcePos, olc::vf2d sourceSize, olc::Pixel tint = olc::WHITE) override { Frame.DrawCalls++; if (inner) inner->DrawPartialCanvas(canvas, pos, sourcePos, sourceSize, tint); }
+		void DrawQuad(olc::vi2d pos, olc::vi2d size, olc::Pixel p) override { Frame.DrawCalls++; if (inner) inner->DrawQuad(pos, size, p); }
+
+		void BeginComposite(Canvas& target, Rect area) override
+		{
+			Frame.CompositedPixels += (uint64_t)area.Size.x * area.Size.y;
+			if (inner) inner->BeginComposite(target, area);
+		}
+
+		void EndComposite(Canvas& target) override
+		{
+			Frame.TextureUploads++;
+			Frame.UploadedPixels += (uint64_t)target.Size.x * target.Size.y;
+			if (inner) inner->EndComposite(target);
+		}
+
+		/* PrepareRasterize: canvases are only drawn on other threads if the inner backend can, and counted as they are finished */
+		bool PrepareRasterize(size_t workers) override { return inner != NULL && inner->PrepareRasterize(workers); }
+		void RasterizeCanvas(Canvas& canvas, const DisplayList& list, size_t worker) override { inner->RasterizeCanvas(canvas, list, worker); }
+
+		void FinishCanvas(Canvas& canvas, const DisplayList& list) override
+		{
+			Frame.RasterCalls += list.Count() + 1; // and the clear
+			Frame.TextureUploads++;
+			Frame.UploadedPixels += (uint64_t)canvas.Size.x * canvas.Size.y;
+			inner->FinishCanvas(canvas, list);
+		}
+	};
+
+	/* DisplayListRecorder: records the drawing calls made through it into a DisplayList, and passes them on to another backend to draw as they are made, if it has one */
+	class DisplayListRecorder : public RenderBackend
+	{
+	private:
+		RenderBackend* inner = NULL;
+		DisplayList* list = NULL;
+
+		static uint64_t area(olc::vi2d size) { return (uint64_t)std::max(0, size.x) * std::max(0, size.y); }
+
+	public:
+		/* Begin: record into target, a canvas of the given size, and draw with innerBackend, or only record with NULL */
+		void Begin(RenderBackend* innerBackend, DisplayList* target, olc::vi2d size)
+		{
+			inner = innerBackend;
+			list = target;
+			list->Reset(size);
+		}
+
+		void End()
+		{
+			inner = NULL;
+			list = NULL;
+		}
+
+		olc::vi2d ScreenSize() override { return inner ? inner->ScreenSize() : olc::vi2d(0, 0); }
+		void CreateCanvas(Canvas& canvas, olc::vi2d size) override { if (inner) inner->CreateCanvas(canvas, size); }
+		void FreeCanvas(Canvas& canvas) override { if (inner) inner->FreeCanvas(canvas); }
+		void BeginCanvas(Canvas& canvas) override { if (inner) inner->BeginCanvas(canvas); }
+		void EndCanvas(Canvas& canvas) override { if (inner) inner->EndCanvas(canvas); }
+
+		void Clear(olc::Pixel p) override
+		{
+			list->add(DisplayList::Command::Clear, { 0,0 }, list->canvasSize, p);
+			list->pixels += area(list->canvasSize);
+			if (inner)
+				inner->Clear(p);
+		}
+
+		void FillRect(olc::vi2d pos, olc::vi2d size, olc::Pixel p) override
+		{
+			list->add(DisplayList::Command::FillRect, pos, size, p);
+			list->pixels += area(size);
+			if (inner)
+				inner->FillRect(pos, size, p);
+		}
+
+		void DrawRect(olc::vi2d pos, olc::vi2d size, olc::Pixel p) override
+		{
+			list->add(DisplayList::Command::DrawRect, pos, size, p);
+			list->pixels += 2 * (uint64_t)(std::max(0, size.x) + std::max(0, size.y));
+			if (inner)
+				inner->DrawRect(pos, size, p);
+		}
+
+		void DrawBevel(RUI::BorderType borderType, Rect area) override
+		{
+			list->add(DisplayList::Command::Bevel, area.Position, area.Size, olc::BLANK, 1, 0, (uint8_t)borderType);
+			list->pixels += 4 * (uint64_t)(std::max(0, area.Size.x) + std::max(0, area.Size.y));
+			if (inner)
+				inner->DrawBevel(borderType, area);
+		}
+
+		/* DrawString: recorded as its layout, so the list never has to lay it out again */
+		void DrawString(olc::vi2d pos, const std::string& text, olc::Pixel p, uint32_t scale) override { DrawTextLayout(pos, *LayoutText(text), p, scale); }
+		olc::vi2d GetTextSize(const std::string& text) override { return inner ? inner->GetTextSize(text) : LayoutText(text)->Size; }
+
+		void DrawTextLayout(olc::vi2d pos, const TextLayout& layout, olc::Pixel p, uint32_t scale, size_t first = 0) override
+		{
+			// keep the layout alive for replays, copying it if it isn't a shared one
+			std::shared_ptr<const TextLayout> kept = layout.weak_from_this().lock();
+			list->add(DisplayList::Command::Text, pos, { (int)first, 0 }, p, scale, (uint32_t)list->layouts.size());
+			list->layouts.push_back(kept != NULL ? kept : std::make_shared<const TextLayout>(layout));
+			list->pixels += area(layout.Size * (int)scale);
+			if (inner)
+				inner->DrawTextLayout(pos, layout, p, scale, first);
+		}
+
+		void DrawSprite(olc::vi2d pos, olc::Sprite* sprite, uint32_t scale) override
+		{
+			list->add(DisplayList::Command::Sprite, pos, { sprite->width, sprite->height }, olc::WHITE, scale, (uint32_t)list->sprites.size());
+			list->sprites.push_back({ sprite, { 0,0 } });
+			list->pixels += area(olc::vi2d(sprite->width, sprite->height) * (int)scale);
+			if (inner)
+				inner->DrawSprite(pos, sprite, scale);
+		}
+
+		void DrawPartialSprite(olc::vi2d pos, olc::Sprite* sprite, olc::vi2d sourcePos, olc::vi2d size, uint32_t scale) override
+		{
+			list->add(DisplayList::Command::PartialSprite, pos, size, olc::WHITE, scale, (uint32_t)list->sprites.size());
+			list->sprites.push_back({ sprite, sourcePos });
+			list->pixels += area(size * (int)scale);
+			if (inner)
+				inner->DrawPartialSprite(pos, sprite, sourcePos, size, scale);
+		}
+
+		void DrawCanvas(Canvas& canvas, olc::vf2d pos, olc::Pixel tint = olc::WHITE) override { if (inner) inner->DrawCanvas(canvas, pos, tint); }
+		void DrawPartialCanvas(Canvas& canvas, olc::vf2d pos, olc::vf2d sourcePos, olc::vf2d sourceSize, olc::Pixel tint = olc::WHITE) override { if (inner) inner->DrawPartialCanvas(canvas, pos, sourcePos, sourceSize, tint); }
+		void DrawQuad(olc::vi2d pos, olc::vi2d size, olc::Pixel p) override { if (inner) inner->DrawQuad(pos, size, p); }
+		void BeginComposite(Canvas& target, Rect area) override { if (inner) inner->BeginComposite(target, area); }
+		void EndComposite(Canvas& target) override { if (inner) inner->EndComposite(target); }
+	};
+
+	/* SolidBackground: creates a control background of a solid color */
+	class SolidBackground : public UIBackground
+	{
+	private:
+		SolidBackground() {}
+	public:
+		static SolidBackground* BLANK; // explicitly have a transparent one, as it is the default
+		olc::Pixel Color = olc::BLANK;
+		SolidBackground(olc::Pixel clr)
+		{
+			Color = clr;
+		}
+		void Render(RenderBackend* rb, Rect area, float fElapsedTime) override
+		{
+			rb->FillRect(area.Position, area.Size, Color); // canvases are always drawn with UI::TrueAlpha
+		}
+	};
+	SolidBackground* SolidBackground::BLANK = new SolidBackground(olc::BLANK);
+
+	/* DecalBackground: creates a control background with a single decal.  It can be scaled, tinted, and aligned */
+	class SpriteBackground : public UIBackground
+	{
+	private:
+		SpriteBackground();
+	public:
+		olc::Sprite* oSprite;
+		FullAlignment ImageAlignment;
+		int ImageScale;
+		//olc::Pixel Tint = olc::WHITE;
+
+		SpriteBackground(olc::Sprite* sprite, FullAlignment alignment = { RUI::Alignment::Center, RUI::Alignment::Center }, int scale = 1/*, olc::Pixel tint = olc::WHITE*/)
+		{
+			oSprite = sprite;
+			ImageAlignment = alignment;
+			ImageScale = scale;
+			//Tint = tint;
+		}
+
+		void Render(RenderBackend* rb, Rect area, float fElapsedTime) override
+		{
+			olc::vf2d spos = area.Position;
+			olc::vi2d dsize = { oSprite->width, oSprite->height };
+			dsize *= ImageScale;
+			if (ImageAlignment.Horizontal == RUI::Alignment::Far)
+				spos.x = (float)(area.right() - dsize.x);
+			else if (ImageAlignment.Horizontal == RUI::Alignment::Center)
+				spos.x += (area.Size.x - dsize.x) / 2;
+
+			if (ImageAlignment.Vertical == RUI::Alignment::Far)
+				spos.y = (float)(area.bottom() - dsize.y);
+			else if (ImageAlignment.Vertical == RUI::Alignment::Center)
+				spos.y += (area.Size.y - dsize.y) / 2;
+
+			rb->DrawSprite(spos, oSprite, ImageScale);
+		}
+	};
+
+	/* TiledDecalBackground: creates a control background that tiles a decal on the X and Y axis.  It can be scaled and tinted */
+	class TiledSpriteBackground : public UIBackground
+	{
+	private:
+		TiledSpriteBackground();
+	public:
+		olc::Sprite* oSprite;
+		int ImageScale;
+		//olc::Pixel Tint = olc::WHITE;
+
+		TiledSpriteBackground(olc::Sprite* decal, int scale = 1 /*, olc::Pixel tint = olc::WHITE*/)
+		{
+			oSprite = decal;
+			ImageScale = scale;
+			//Tint = tint;
+		}
+
+		void Render(RenderBackend* rb, Rect area, float fElapsedTime) override
+		{
+			olc::vi2d dsize = { oSprite->width, oSprite->height };
+			dsize *= ImageScale;
+
+			for (int y = 0; y < area.Size.y; y += dsize.y)
+			{
+				for (int x = 0; x < area.Size.x; x += dsize.x)
+				{
+					int w = dsize.x;
+					int h = dsize.y;
+
+					if (x + dsize.x > area.Size.x)
+						w = (area.Size.x - x);
+					if (y + dsize.y > area.Size.y)
+						h = (area.Size.y - y);
+
+					olc::vi2d loc1 = { area.Position.x + x,area.Position.y + y };
+					olc::vi2d siz1 = { w,h };
+					rb->DrawPartialSprite(loc1, oSprite, { 0,0 }, siz1, ImageScale);
+
+				}
+			}
+		}
+	};
+
+	/* AnimatedSpriteBackground: plays the frames of a sprite sheet at its own rate.  Frames are FrameSize each, left to right then top to bottom.
+		Controls showing it only redraw when the frame changes, and it only keeps time while one of them is visible and on screen, so hidden animations pause. */
+	class AnimatedSpriteBackground : public UIBackground
+	{
+	private:
+		AnimatedSpriteBackground();
+		float time = 0;
+		int frame = 0;
+
+	public:
+		olc::Sprite* oSprite;
+		olc::vi2d FrameSize;
+		/* FrameCount: the number of frames in the sheet to play */
+		int FrameCount;
+		float FramesPerSecond;
+		/* Loop: go back to the first frame after the last, or stop on the last */
+		bool Loop = true;
+		/* Playing: set to false to hold the current frame */
+		bool Playing = true;
+		FullAlignment ImageAlignment;
+		int ImageScale;
+
+		/* Constructor: frameCount 0 plays every frame in the sheet, a frameSize of 0 (or less) across or down is the whole sheet that way.  A NULL sheet draws nothing. */
+		AnimatedSpriteBackground(olc::Sprite* sheet, olc::vi2d frameSize, float framesPerSecond, int frameCount = 0, FullAlignment alignment = { RUI::Alignment::Center, RUI::Alignment::Center }, int scale = 1)
+		{
+			oSprite = sheet;
+			olc::vi2d sheetSize = sheet != NULL ? olc::vi2d(sheet->width, sheet->height) : olc::vi2d(0, 0);
+			FrameSize = { frameSize.x > 0 ? frameSize.x : std::max(1, sheetSize.x), frameSize.y > 0 ? frameSize.y : std::max(1, sheetSize.y) };
+			FramesPerSecond = framesPerSecond;
+			FrameCount = frameCount > 0 ? frameCount : std::max(1, (sheetSize.x / FrameSize.x) * (sheetSize.y / FrameSize.y));
+			ImageAlignment = alignment;
+			ImageScale = scale;
+			Animated = true;
+		}
+
+		/* Play, Pause: start and stop the frames advancing, Pause holds the current frame */
+		void Play() { Playing = true; }
+		void Pause() { Playing = false; }
+
+		/* GetFrame, SetFrame: the frame showing */
+		int GetFrame() { return frame; }
+		void SetFrame(int index)
+		{
+			index = std::max(0, std::min(index, FrameCount - 1));
+			time = 0;
+			if (index != frame)
+			{
+				frame = index;
+				Changes++;
+			}
+		}
+
+		void Tick(float fElapsedTime) override
+		{
+			if (!Playing || FramesPerSecond <= 0 || FrameCount <= 1)
+				return;
+			time += fElapsedTime;
+			float frameTime = 1.0f / FramesPerSecond;
+			if (time < frameTime)
+				return;
+			int steps = (int)(time / frameTime);
+			time -= steps * frameTime;
+			int next = frame + steps;
+			if (Loop)
+				next %= FrameCount;
+			else
+				next = std::min(next, FrameCount - 1);
+			if (next != frame)
+			{
+				frame = next;
+				Changes++;
+			}
+		}
+
+		void Render(RenderBackend* rb, Rect area, float fElapsedTime) override
+		{
+			if (oSprite == NULL)
+				return;
+			int columns = std::max(1, oSprite->width / std::max(1, FrameSize.x));
+			olc::vi2d source = { (frame % columns) * FrameSize.x, (frame / columns) * FrameSize.y };
+			olc::vi2d dsize = FrameSize * ImageScale;
+			olc::vi2d spos = area.Position;
+			if (ImageAlignment.Horizontal == RUI::Alignment::Far)
+				spos.x = area.right() - dsize.x;
+			else if (ImageAlignment.Horizontal == RUI::Alignment::Center)
+				spos.x += (area.Size.x - dsize.x) / 2;
+
+			if (ImageAlignment.Vertical == RUI::Alignment::Far)
+				spos.y = area.bottom() - dsize.y;
+			else if (ImageAlignment.Vertical == RUI::Alignment::Center)
+				spos.y += (area.Size.y - dsize.y) / 2;
+
+			rb->DrawPartialSprite(spos, oSprite, source, FrameSize, ImageScale);
+		}
+	};
+
+	/* ChildList: the children of a control, kept in a dense array in z order (bottom first).
+		Each child carries a ZIndex, raising a child just gives it the highest ZIndex and remembers it, and the array is put
+		back in order by Sort, so popping a window to the top is O(1) no matter how many siblings it has.  The UIManager sorts
+		raised lists before it hit tests and before it draws, never while they may be iterated.
+		Iterating goes by index over the children there were when it started, so children can be added, removed or raised
+		from inside a loop over them (by an Update or an event handler): ones added are not visited, ones removed may skip one. */
+	template <class T>
+	class ChildList
+	{
+	private:
+		std::vector<T*> items;
+		/* raised: children raised since the array was last in order */
+		std::vector<T*> raised;
+		uint32_t nextZIndex = 0;
+
+	public:
+		/* Sort: put raised children back in z order.  Not while the list is being iterated. */
+		void Sort()
+		{
+			if (raised.empty())
+				return;
+			auto byZ = [](T* a, T* b) { return a->ZIndex < b->ZIndex; };
+			if (raised.size() > 16)
+				std::sort(items.begin(), items.end(), byZ);
+			else
+			{
+				// the rest are still in order, so pull the raised ones out and put them back on top
+				std::sort(raised.begin(), raised.end(), byZ);
+				raised.erase(std::unique(raised.begin(), raised.end()), raised.end());
+				items.erase(std::remove_if(items.begin(), items.end(), [&](T* c) { return std::find(raised.begin(), raised.end(), c) != raised.end(); }), items.end());
+				items.insert(items.end(), raised.begin(), raised.end());
+			}
+			raised.clear();
+		}
+
+		/* Unsorted: some children were raised since the last Sort */
+		bool Unsorted() const { return !raised.empty(); }
+
+		/* iterator, reverse_iterator: index based, they end early if children are removed under them */
+		class iterator
+		{
+		private:
+			const std::vector<T*>* items;
+			size_t i;
+		public:
+			iterator(const std::vector<T*>* items, size_t i) : items(items), i(i) {}
+			T* operator*() const { return (*items)[i]; }
+			iterator& operator++() { i++; return *this; }
+			bool operator!=(const iterator& other) const { return i != other.i && i < items->size(); }
+			bool operator==(const iterator& other) const { return !(*this != other); }
+		};
+		class reverse_iterator
+		{
+		private:
+			const std::vector<T*>* items;
+			size_t i; // one past the child it is at
+		public:
+			reverse_iterator(const std::vector<T*>* items, size_t i) : items(items), i(i) {}
+			T* operator*() const { return (*items)[i - 1]; }
+			reverse_iterator& operator++() { i--; return *this; }
+			bool operator!=(const reverse_iterator& other) const { return i != other.i && i <= items->size(); }
+			bool operator==(const reverse_iterator& other) const { return !(*this != other); }
+		};
+
+		/* push_back: add a child on top of its siblings */
+		void push_back(T* control)
+		{
+			control->ZIndex = nextZIndex++;
+			items.push_back(control);
+			if (!raised.empty())
+				raised.push_back(control); // so it stays above the pending ones
+		}
+
+		/* Raise: move a child on top of its siblings, at the next Sort */
+		void Raise(T* control)
+		{
+			control->ZIndex = nextZIndex++;
+			if (!raised.empty() || items.empty() || items.back() != control)
+				raised.push_back(control);
+		}
+
+		/* IsTop: whether a child is on top of its siblings, sorted or not */
+		bool IsTop(T* control) const { return nextZIndex > 0 && control->ZIndex == nextZIndex - 1; }
+
+		void remove(T* control)
+		{
+			items.erase(std::remove(items.begin(), items.end(), control), items.end());
+			raised.erase(std::remove(raised.begin(), raised.end(), control), raised.end());
+		}
+
+		void clear()
+		{
+			items.clear();
+			raised.clear();
+		}
+
+		size_t size() const { return items.size(); }
+		bool empty() const { return items.empty(); }
+
+		T* front() { return items.front(); }
+		T* back() { return items.back(); }
+		T* operator[](size_t i) { return items[i]; }
+
+		iterator begin() const { return iterator(&items, 0); }
+		iterator end() const { return iterator(&items, items.size()); }
+		reverse_iterator rbegin() const { return reverse_iterator(&items, items.size()); }
+		reverse_iterator rend() const { return reverse_iterator(&items, 0); }
+	};
+
+	/* SpatialGrid: an optional index over the children of a control, in the control's own coordinates, so hit testing
+		only looks at the children near the mouse.  Each cell keeps its children in z order, bottom first, like Controls. */
+	class SpatialGrid
+	{
+	private:
+		struct Item
+		{
+			ControlBase* control;
+			Rect rect;
+			uint32_t order; // z order, higher is on top
+		};
+		struct CellRange
+		{
+			int x1, y1, x2, y2;
+			uint32_t order;
+		};
+
+		uint32_t nextOrder = 0;
+		int cellSize;
+		int cols = 1;
+		int rows = 1;
+		std::vector<std::vector<Item>> cells;
+		std::unordered_map<ControlBase*, CellRange> entries;
+
+		CellRange rangeOf(Rect rect)
+		{
+			CellRange r;
+			r.x1 = std::min(cols - 1, std::max(0, rect.Position.x / cellSize));
+			r.y1 = std::min(rows - 1, std::max(0, rect.Position.y / cellSize));
+			r.x2 = std::min(cols - 1, std::max(0, rect.right() / cellSize));
+			r.y2 = std::min(rows - 1, std::max(0, rect.bottom() / cellSize));
+			return r;
+		}
+
+		void removeFromCells(ControlBase* control, CellRange r)
+		{
+			for (int y = r.y1; y <= r.y2; y++)
+			{
+				for (int x = r.x1; x <= r.x2; x++)
+				{
+					std::vector<Item>& cell = cells[y * cols + x];
+					for (size_t i = 0; i < cell.size(); i++)
+					{
+						if (cell[i].control == control)
+						{
+							cell.erase(cell.begin() + i);
+							break;
+						}
+					}
+				}
+			}
+		}
+
+		void addToCells(ControlBase* control, Rect rect, CellRange r)
+		{
+			for (int y = r.y1; y <= r.y2; y++)
+			{
+				for (int x = r.x1; x <= r.x2; x++)
+				{
+					std::vector<Item>& cell = cells[y * cols + x];
+					if (cell.empty() || cell.back().order < r.order)
+						cell.push_back({ control, rect, r.order });
+					else // keep the cell sorted, it slots in below anything that is above it
+						cell.insert(std::upper_bound(cell.begin(), cell.end(), r.order, [](uint32_t o, const Item& item) { return o < item.order; }), { control, rect, r.order });
+				}
+			}
+		}
+
+	public:
+		SpatialGrid(olc::vi2d size, int cellsize)
+		{
+			cellSize = std::max(1, cellsize);
+			Resize(size);
+		}
+
+		/* Resize: change the area covered, which empties the grid */
+		void Resize(olc::vi2d size)
+		{
+			cols = std::max(1, (size.x / cellSize) + 1);
+			rows = std::max(1, (size.y / cellSize) + 1);
+			cells.assign(cols * rows, std::vector<Item>());
+			entries.clear();
+		}
+
+		void Clear()
+		{
+			for (auto& cell : cells)
+				cell.clear();
+			entries.clear();
+		}
+
+		/* Insert: add a control on top of everything already in the grid */
+		void Insert(ControlBase* control, Rect rect)
+		{
+			CellRange r = rangeOf(rect);
+			r.order = nextOrder++;
+			entries[control] = r;
+			addToCells(control, rect, r);
+		}
+
+		void Remove(ControlBase* control)
+		{
+			auto it = entries.find(control);
+			if (it == entries.end())
+				return;
+			removeFromCells(control, it->second);
+			entries.erase(it);
+		}
+
+		/* Update: the control moved or resized, it keeps its place in the z order */
+		void Update(ControlBase* control, Rect rect)
+		{
+			auto it = entries.find(control);
+			if (it == entries.end())
+				return;
+			CellRange r = rangeOf(rect);
+			CellRange o = it->second;
+			r.order = o.order;
+			if (r.x1 == o.x1 && r.y1 == o.y1 && r.x2 == o.x2 && r.y2 == o.y2)
+			{
+				// same cells, just update the rectangle in place
+				for (int y = r.y1; y <= r.y2; y++)
+					for (int x = r.x1; x <= r.x2; x++)
+						for (auto& item : cells[y * cols + x])
+							if (item.control == control)
+								item.rect = rect;
+				return;
+			}
+			removeFromCells(control, o);
+			it->second = r;
+			addToCells(control, rect, r);
+		}
+
+		/* Raise: move a control to the top of the z order */
+		void Raise(ControlBase* control, Rect rect)
+		{
+			Remove(control);
+			Insert(control, rect);
+		}
+
+		/* HitTest: offer the children whose rectangle contains the point to test, topmost first, returning the first non NULL result */
+		template <class TestFunc>
+		ControlBase* HitTest(olc::vi2d point, TestFunc test)
+		{
+			int x = std::min(cols - 1, std::max(0, point.x / cellSize));
+			int y = std::min(rows - 1, std::max(0, point.y / cellSize));
+			std::vector<Item>& cell = cells[y * cols + x];
+			for (auto item = cell.rbegin(); item != cell.rend(); ++item)
+			{
+				if (item->rect.Contains(point))
+				{
+					ControlBase* res = test(item->control);
+					if (res != NULL)
+						return res;
+				}
+			}
+			return NULL;
+		}
+	};
+
+	/* ControlBase: the base control for the UI system.
+		This can be used as a label, a panel, a button, an image, just about anything.
+		You can also derive from it and create addition custom controls, as well as build composite controls.
+	*/
+	class ControlBase
+	{
+	protected:
+		/* Location: The controls location and size, relative to its parent */
+		Rect Location;
+
+		bool CanvasValid = false;
+
+		std::string Text;
+
+	public:
+		/* PopToTop: use this function to grab the top level parent of this control and pop him to the front of z order */
+		virtual void PopToTop()
+		{
+			if (Parent && Parent->Parent == NULL)
+			{
+				if (!Parent->Controls.IsTop(this))
+					damageSelf();
+				bool sorted = !Parent->Controls.Unsorted();
+				Parent->Controls.Raise(this);
+				if (sorted && Parent->Controls.Unsorted())
+				{
+					if (Context != NULL)
+						Context->Raised.push_back(Parent); // we may be inside a loop over Controls, the UIManager sorts them later
+					else
+						Parent->Controls.Sort();
+				}
+				if (Parent->ChildIndex != NULL)
+					Parent->ChildIndex->Raise(this, Location);
+			}
+			else if (Parent)
+			{
+				Parent->PopToTop();
+			}
+		}
+
+		/* SetPosition: set the position of the control, relative to its parent */
+		void SetPosition(olc::vi2d loc)
+		{
+			if (loc != Location.Position)
+			{
+				damageSelf(); // where we were
+				Location.Position = loc;
+				invalidateScreenPos();
+				damageSelf();
+			}
+			if (Parent != NULL && Parent->ChildIndex != NULL)
+				Parent->ChildIndex->Update(this, Location);
+			raise(RaisedMove);
+		}
+
+		void SetPosition(int x, int y)
+		{
+			SetPosition({ x,y });
+		}
+		/* Position: get the position of the control, relative to its parent */
+		olc::vi2d Position()
+		{
+			return Location.Position;
+		}
+
+		/* SetSize: set the size of the control */
+		void SetSize(int w, int h)
+		{
+			SetSize({ w, h });
+		}
+		void SetSize(olc::vi2d size)
+		{
+			damageSelf(); // in case we shrank
+			Location.Size = size;
+			if (Parent != NULL && Parent->ChildIndex != NULL)
+				Parent->ChildIndex->Update(this, Location);
+			if (ChildIndex != NULL)
+				rebuildIndex();
+			raise(RaisedResize);
+			Invalidate();
+		}
+
+		/* Size: get the size of the control */
+		olc::vi2d Size()
+		{
+			return Location.Size;
+		}
+
+		/* Invalidate: our canvas needs drawing again, and what it looks like changed, so the display lists recorded for it are stale */
+		void Invalidate()
+		{
+			staleCanvas();
+			recordedStates = 0;
+			damageSelf();
+		}
+
+		/* RecordDrawing: record the drawing of our canvas into a display list for each state (default, hover, active, disabled) we are drawn in,
+			and replay it when only our state changes instead of drawing again.  Only drawing done through the RenderBackend is recorded, so turn it off
+			if DrawBackground, DrawCustom or DrawText draw with the engine itself, or if what they draw changes with anything but our state, without an Invalidate. */
+		bool RecordDrawing = true;
+
+		/* GetDisplayList: what our canvas was drawn with in our current state, NULL if it isn't recorded (yet) */
+		const DisplayList* GetDisplayList()
+		{
+			int state = GetStateVal();
+			return (recordedStates & (1 << state)) ? displayLists[state] : NULL;
+		}
+
+		/* InvalidateOverlay: only what DrawOverlay draws changed, the canvas is kept as it is */
+		void InvalidateOverlay()
+		{
+			damageSelf();
+		}
+
+		/* SetTint: multiply the colors of this control and its children by tint as they are composited, like a decal tint.
+			Fades and color pulses done this way don't redraw any canvas. */
+		void SetTint(olc::Pixel tint)
+		{
+			if (tint == Tint)
+				return;
+			Tint = tint;
+			damageSelf();
+		}
+		olc::Pixel GetTint() { return Tint; }
+
+		/* Update: called once a frame for every visible control, before anything is drawn.
+		   Override it for anything time based, and call Invalidate if it changes how the control looks. */
+		virtual void Update(float fElapsedTime) { }
+
+		/* OnClick: Event handler, invoked when any (left,right,middle) mouse buttons are pressed while over this control, AND it was enabled. */
+		EventHandler1Param<int> OnClick;
+		/* OnMouseDown: Event handler, invoked when any (left,right,middle) mouse buttons enters the pressed state while over this control, AND it was enabled. */
+		EventHandler1Param<int> OnMouseDown;
+		/* OnMouseDown: Event handler, invoked when any (left,right,middle) mouse buttons enters the released state while over this control OR the control was the last target of mouse down, AND it was enabled. */
+		EventHandler1Param<int> OnMouseUp;
+		/* OnMouseEnter: Event Handler, invoked when the mouse STARTS hovering over this control */
+		EventHandler OnMouseEnter;
+		/* OnMouseLeave: Event Handler, invoked when the mouse STOPS hovering over this control */
+		EventHandler OnMouseLeave;
+		/* OnMouseMove: Event Handler, invoked when the mouse moves while hovering over this control, or the control is the current mouse down target */
+		EventHandler OnMouseMove;
+		/* OnFocus: Event Handler, called when this control gains input focus */
+		EventHandler OnFocus;
+		/* OnFocus: Event Handler, called when this control loses input focus */
+		EventHandler OnBlur;
+		/* OnMove: Event Handler, called when this control's location changes */
+		EventHandler OnMove;
+		/* OnResize: Event Handler, called when this control's size changes */
+		EventHandler OnResize;
+
+		/* Parent: The control's parent if any */
+		ControlBase* Parent = NULL;
+
+		/* Context: shared state of the UIManager this control belongs to, taken from the parent.  NULL outside of a UIManager. */
+		UIContext* Context = NULL;
+
+		/* Theme: the ControlTheme for this control, shared with any control it was applied to.  Use Theme.Edit() to change it. */
+		ThemeHandle Theme = ThemeHandle::ControlDefault();
+
+		/* Text: Any text to display on this control.  Text Scale and Text Align will be used to determine its size and location */
+		virtual std::string GetText() {return Text;}
+		virtual void SetText(std::string val)
+		{ 
+			if (Text != val)
+			{
+				Text = val;
+				Invalidate();
+			}
+		}
+
+		/* Active: wether the control is currently "Active" is used for an additional state to be used differently as needed.  In list items, it can serve as the selected item color, for example. */
+		bool Active = false;
+
+		/* Active: wether the control is currently "Active" is used for an additional state to be used differently as needed.  In list items, it can serve as the selected item color, for example. */
+		bool Visible = true;
+
+		/* Enabled: wether the control uses its Disabled state (if not .empty), and wether it responds to hover and click state transitions */
+		bool Enabled = true;
+
+		/* CanFocus: Determines wether the control can take input focus.  If it cant, it can still remove the focus of the current control if selected. */
+		bool CanFocus = false;
+
+		/* Name: entirely an external ID to allow you to track where an event came from, and what "#Name" StyleSheet rules match.  Call Restyle after changing it. */
+		std::string Name = "";
+
+		/* TypeName: the type StyleSheet rules match this control by.  Override it in your own controls to style them separately. */
+		virtual const char* TypeName() const { return "ControlBase"; }
+
+		/* Styled: whether a StyleSheet may replace this control's Theme.  Clear it to keep a hand made theme. */
+		bool Styled = true;
+
+		/* Restyle: resolve this control's theme from the StyleSheet again on the next update, for when its Name changes */
+		void Restyle() { styledBy = NULL; }
+
+		/* Controls: all Controls ARE containers, so we need a list of controls, to render and manage user input */
+		ChildList<ControlBase> Controls;
+
+		/* ZIndex: our place in the z order of our parent's Controls, higher is on top.  Set by Controls. */
+		uint32_t ZIndex = 0;
+
+		/* Hovering: is the mouse currently hovering over this control... don't set it unless you are writing an input handler, but it can be read any time */
+		bool Hovering = false;
+
+		/* UseSpatialIndex: index the children of this control in a grid, so hit testing only visits the children under the mouse.
+		   Worth it for containers with many children, it is kept up to date as children move, resize and pop to the top. */
+		void UseSpatialIndex(int cellSize = 32)
+		{
+			delete ChildIndex;
+			ChildIndex = new SpatialGrid(Location.Size, cellSize);
+			rebuildIndex();
+		}
+
+		/* Constructor: Basic constructor for a control to create it within a parent */
+		ControlBase(Rect location, ControlBase* parent = NULL)
+		{
+			Location = location;
+			Parent = parent;
+			if (Parent != NULL)
+			{
+				Context = Parent->Context;
+				Parent->Controls.push_back(this);
+				if (Parent->ChildIndex != NULL)
+					Parent->ChildIndex->Insert(this, Location);
+				damageSelf();
+				if (Context != NULL)
+					Context->StaleCanvases++;
+			}
+		}
+
+		/* Constructor: create a control within a parent and set its theme */
+		ControlBase(Rect location, const ThemeHandle& theme, ControlBase* parent = NULL)
+		{
+			Location = location;
+			Parent = parent;
+			ApplyTheme(theme);
+
+			if (Parent != NULL)
+			{
+				Context = Parent->Context;
+				Parent->Controls.push_back(this);
+				if (Parent->ChildIndex != NULL)
+					Parent->ChildIndex->Insert(this, Location);
+				damageSelf();
+				if (Context != NULL)
+					Context->StaleCanvases++;
+			}
+		}
+
+		/* Constructor: base simple constructor for future expansion and complex custom controls */
+		ControlBase() { }
+
+		/* MouseOver: meant to be handled in the OnUserUpdate call in olcPixelGameEngine, with the mouse coordinates, to handle mouse interaction */
+		virtual ControlBase* MouseOver(olc::vi2d mpos)
+		{
+			if (Visible)
+			{
+				Rect sRect = ScreenRect();
+				if (Enabled && sRect.Contains(mpos))
+				{
+					if (ChildIndex != NULL)
+					{
+						ControlBase* res = ChildIndex->HitTest(mpos - sRect.Position, [&](ControlBase* control) { return control->MouseOver(mpos); });
+						if (res != NULL)
+						{
+							Hovering = false;
+							return res;
+						}
+						Hovering = true;
+						return this;
+					}
+					for (auto control = Controls.rbegin(); control != Controls.rend(); ++control)
+					{
+						ControlBase* res = (*control)->MouseOver(mpos);
+						if (res != NULL)
+						{
+							Hovering = false;
+							return res;
+						}
+					}
+					Hovering = true;
+					return this;
+				}
+			}
+			Hovering = false;
+			return NULL;
+		}
+
+		/* ApplyTheme: Change the theme of a control, sharing it.  individual aspects of a theme can also be changed at any time with Theme.Edit(). */
+		void ApplyTheme(const ThemeHandle& theme)
+		{
+			if (Theme != theme)
+			{
+				Theme = theme;
+				Invalidate();
+			}
+		}
+
+		/* Focus: Give this control input focus. */
+		virtual void Focus()
+		{
+			OnFocus.Invoke(this);
+		};
+
+		/* Blur: remove the current input focus. */
+		virtual void Blur()
+		{
+			OnBlur.Invoke(this);
+		};
+
+		/* MouseEnter: The mouse started hovering over your control. */
+		virtual void MouseEnter()
+		{
+			OnMouseEnter.Invoke(this);
+		};
+
+		/* MouseLeave: The mouse was hovering over your control, and has now left. */
+		virtual void MouseLeave()
+		{
+			OnMouseLeave.Invoke(this);
+		};
+
+		/* MouseDown: Event when a mouse is in the bPressed state on this control. */
+		virtual void MouseDown(int mButton)
+		{
+			OnMouseDown.Invoke(this, mButton);
+		};
+
+		/* MouseUp: Event when a mouse is in the bReleased state, to the control previously notified by mousedown. */
+		virtual void MouseUp(int mButton)
+		{
+			OnMouseUp.Invoke(this, mButton);
+		};
+
+		/* MouseMove: The mouse moved. */
+		virtual void MouseMove()
+		{
+			OnMouseMove.Invoke(this);
+		};
+
+		/* HandleFocusInput: Called during game update if you have input focus, so you can check for any keyboard atcivity */
+		virtual void HandleFocusInput(const InputState& input, float fElapsedTime) { }
+
+		/* Destructor: In case noone cleaned up the children before destroying the control */
+		virtual ~ControlBase()
+		{
+			if (Visible)
+				damageSelf();
+			if (raisedEvents != 0 && Context != NULL)
+				Context->Events.Remove(this);
+			if (Controls.Unsorted() && Context != NULL)
+				std::replace(Context->Raised.begin(), Context->Raised.end(), this, (ControlBase*)NULL);
+			if (animated)
+				stopAnimations();
+			if (mCanvas.Owner != NULL)
+				mCanvas.Owner->FreeCanvas(mCanvas);
+			for (auto list : displayLists)
+				delete list;
+			delete ChildIndex;
+			for (auto control : Controls)
+			{
+				try
+				{
+					delete control;
+				}
+				catch (...) {} // may not be our memory to clean, but dont want to leave it hanging if we are disappearing
+			}
+		}
+	protected:
+		/* Tint: see SetTint.  inheritedTint is our parent's, and drawTint both together, as of the last Render */
+		olc::Pixel Tint = olc::WHITE;
+		olc::Pixel inheritedTint = olc::WHITE;
+		olc::Pixel drawTint = olc::WHITE;
+
+		/* animated: an Animator has animated this control, so it has to be told when we are deleted */
+		friend class Animator;
+		bool animated = false;
+		void stopAnimations();
+
+		/* ChildIndex: the spatial index of Controls, if UseSpatialIndex was called */
+		SpatialGrid* ChildIndex = NULL;
+
+		/* rebuildIndex: put every child back into ChildIndex, in z order */
+		void rebuildIndex()
+		{
+			ChildIndex->Resize(Location.Size);
+			std::vector<ControlBase*> children;
+			for (auto control : Controls)
+				children.push_back(control);
+			std::stable_sort(children.begin(), children.end(), [](ControlBase* a, ControlBase* b) { return a->ZIndex < b->ZIndex; }); // Controls may not be sorted yet
+			for (auto control : children)
+				ChildIndex->Insert(control, control->Location);
+		}
+
+		/* screenPos: cached result of ScreenPos, only trusted while screenPosValid.
+		   A valid control always has a valid parent, so invalidating can stop at the first control that is already invalid. */
+		olc::vi2d screenPos = { 0,0 };
+		bool screenPosValid = false;
+
+		/* invalidateScreenPos: our position or an ancestor's changed, so the cached screen position of our subtree is stale */
+		void invalidateScreenPos()
+		{
+			if (!screenPosValid)
+				return;
+			screenPosValid = false;
+			for (auto control : Controls)
+				control->invalidateScreenPos();
+		}
+
+		/* ScreenPos: Our location in screen space */
+		olc::vi2d ScreenPos()
+		{
+			if (!screenPosValid)
+			{
+				screenPos = Location.Position;
+				if (Parent != NULL)
+					screenPos += Parent->ScreenPos();
+				screenPosValid = true;
+			}
+			return screenPos;
+		}
+
+		/* ScreenRect: Our rectangle in screen space */
+		Rect ScreenRect()
+		{
+			return { ScreenPos(), Location.Size };
+		}
+
+		/* damageSelf: tell the compositor the area we cover needs compositing again */
+		void damageSelf()
+		{
+			if (Context != NULL && Context->Damage.Enabled)
+				Context->Damage.Add(ScreenRect());
+		}
+
+		/* UpdateTree: the per frame update pass, catches state and visibility changes before anything is drawn, and calls Update */
+		void UpdateTree(float fElapsedTime)
+		{
+			if (Visible != lastVisible)
+			{
+				lastVisible = Visible;
+				damageSelf();
+			}
+			if (!Visible)
+				return;
+			if (Styled && Context != NULL && Context->Styles != NULL)
+				restyle(Context->Styles);
+			if (lastStateVal != GetStateVal())
+			{
+				// only our state changed, so the display list recorded for it (if any) is still good
+				staleCanvas();
+				damageSelf();
+				lastStateVal = GetStateVal();
+			}
+			animateBackground(fElapsedTime);
+			Update(fElapsedTime);
+			for (auto control : Controls)
+				control->UpdateTree(fElapsedTime);
+		}
+
+		/* backgroundChanges: the Changes of our background when our canvas was last drawn */
+		uint32_t backgroundChanges = 0;
+
+		/* animateBackground: tick an animated background while we can be seen, and redraw if it changed since we drew it */
+		void animateBackground(float fElapsedTime)
+		{
+			UIBackground* background = Theme->GetStyle(Enabled, Hovering, Active).Background;
+			if (background == NULL || !background->Animated || Context == NULL || !onScreen())
+				return;
+			if (background->tickedFrame != Context->Frame)
+			{
+				background->tickedFrame = Context->Frame;
+				background->Tick(fElapsedTime);
+			}
+			if (background->Changes != backgroundChanges)
+				Invalidate();
+		}
+
+		/* onScreen: some of us is inside every parent's client area, and so on the screen */
+		bool onScreen()
+		{
+			Rect area = ScreenRect();
+			for (ControlBase* parent = Parent; parent != NULL && !area.IsEmpty(); parent = parent->Parent)
+				area = area.Intersection(parent->GetClientRect());
+			return !area.IsEmpty();
+		}
+
+		/* RaisedEvent: the events raise can defer */
+		enum RaisedEvent : uint32_t
+		{
+			RaisedMove = 1, RaisedResize = 2, RaisedValue = 4
+		};
+
+		/* raisedEvents: the events we have waiting in Context's EventQueue */
+		uint32_t raisedEvents = 0;
+
+		/* raise: raise an event now, or queue it when the ui defers events.  A queued event is only raised once however many times it happened. */
+		void raise(RaisedEvent event)
+		{
+			if (Context != NULL && Context->Events.Deferred)
+			{
+				if (raisedEvents == 0)
+					Context->Events.Pending.push_back(this);
+				raisedEvents |= event;
+			}
+			else
+				dispatchEvents(event);
+		}
+
+		/* dispatchEvents: invoke the handlers for the raised events.  Override it to add events of your own. */
+		virtual void dispatchEvents(uint32_t events)
+		{
+			if (events & RaisedMove)
+				OnMove.Invoke(this);
+			if (events & RaisedResize)
+				OnResize.Invoke(this);
+		}
+
+		/* styledBy, styledGeneration: the StyleSheet and generation our Theme was last resolved from */
+		const StyleSheet* styledBy = NULL;
+		uint32_t styledGeneration = 0;
+
+		/* restyle: take our theme from the sheet if it changed since we last did.  A theme that looks the same is shared without redrawing. */
+		void restyle(StyleSheet* sheet)
+		{
+			if (styledBy == sheet && styledGeneration == sheet->Generation())
+				return;
+			styledBy = sheet;
+			styledGeneration = sheet->Generation();
+
+			ThemeHandle theme;
+			if (!sheet->Resolve(TypeName(), Name, theme) || theme == Theme)
+				return;
+			if (*theme == *Theme)
+				Theme = theme;
+			else
+				ApplyTheme(theme);
+		}
+
+		int GetStateVal()
+		{
+			if (!Enabled)
+				return 3;
+			else if (Active)
+				return 2;
+			else if (Hovering)
+				return 1;
+			return 0;
+		}
+
+
+		/* textLayout: Text as laid out by the backend, kept until Text changes */
+		std::shared_ptr<const TextLayout> textLayout;
+
+		const TextLayout& layoutText(RenderBackend* rb)
+		{
+			if (textLayout == NULL || textLayout->Text != Text)
+				textLayout = rb->LayoutText(Text);
+			return *textLayout;
+		}
+
+		Canvas mCanvas;
+		int lastStateVal = 0;
+		bool lastVisible = true;
+
+		/* displayLists: the drawing of our canvas in each state (see GetStateVal), and recordedStates the ones that are up to date, a bit each */
+		DisplayList* displayLists[4] = { NULL, NULL, NULL, NULL };
+		uint8_t recordedStates = 0;
+
+		/* staleCanvas: our canvas needs drawing again */
+		void staleCanvas()
+		{
+			if (CanvasValid && Context != NULL)
+				Context->StaleCanvases++;
+			CanvasValid = false;
+		}
+
+		/* currentList: the display list for our state, if it is up to date and can be replayed as it is, otherwise NULL.  changes is our background's Changes. */
+		DisplayList* currentList(uint32_t changes)
+		{
+			int state = GetStateVal();
+			DisplayList* list = displayLists[state];
+			if ((recordedStates & (1 << state)) && list->CanvasSize() == Location.Size && list->BackgroundChanges == changes)
+				return list;
+			return NULL;
+		}
+
+		/* recordList: record DrawBackground, DrawCustom and DrawText for our state with recorder, drawing them with rb as well unless it is NULL */
+		DisplayList* recordList(DisplayListRecorder* recorder, RenderBackend* rb, float fElapsedTime, uint32_t changes)
+		{
+			int state = GetStateVal();
+			DisplayList* list = displayLists[state];
+			if (list == NULL)
+				list = displayLists[state] = new DisplayList();
+			recorder->Begin(rb, list, Location.Size);
+			DrawBackground(recorder, fElapsedTime);
+			DrawCustom(recorder, fElapsedTime);
+			DrawText(recorder, fElapsedTime);
+			recorder->End();
+			list->BackgroundChanges = changes;
+			recordedStates |= 1 << state;
+			return list;
+		}
+
+		uint32_t currentBackgroundChanges()
+		{
+			UIBackground* background = Theme->GetStyle(Enabled, Hovering, Active).Background;
+			return background != NULL ? background->Changes : 0;
+		}
+
+		/* drawCanvas: replay the display list for our state if it is up to date, otherwise draw with DrawBackground, DrawCustom and DrawText, recording them if we can */
+		void drawCanvas(RenderBackend* rb, float fElapsedTime)
+		{
+			uint32_t changes = currentBackgroundChanges();
+			backgroundChanges = changes;
+			if (DisplayList* list = currentList(changes))
+			{
+				list->Replay(rb);
+				return;
+			}
+
+			DisplayListRecorder* recorder = Context != NULL ? Context->Lists : NULL;
+			if (!RecordDrawing || recorder == NULL)
+			{
+				DrawBackground(rb, fElapsedTime);
+				DrawCustom(rb, fElapsedTime);
+				DrawText(rb, fElapsedTime);
+				return;
+			}
+			recordList(recorder, rb, fElapsedTime, changes);
+		}
+
+		/* preparedFrame: the frame our canvas was last gathered by prepareCanvases in */
+		uint64_t preparedFrame = 0;
+
+		/* prepareCanvases: gather the controls Render would draw a canvas for in clip, creating their canvas and recording their display list (without drawing it),
+			so the UIManager can rasterize them all at once.  Controls that don't record are left for Render to draw. */
+		void prepareCanvases(RenderBackend* rb, float fElapsedTime, Rect clip, std::vector<ControlBase*>& prepared)
+		{
+			if (!Visible)
+				return;
+			Rect sRect = ScreenRect();
+			if (!clip.Intersects(sRect) || clip.IsEmpty() || Location.IsEmpty())
+				return;
+			if ((!CanvasValid || mCanvas.Owner == NULL) && RecordDrawing && Context != NULL && Context->Lists != NULL && preparedFrame != Context->Frame)
+			{
+				uint32_t changes = currentBackgroundChanges();
+				backgroundChanges = changes;
+				if (currentList(changes) == NULL)
+					recordList(Context->Lists, NULL, fElapsedTime, changes);
+				if (mCanvas.Owner == NULL || mCanvas.Size != Location.Size)
+					rb->CreateCanvas(mCanvas, Location.Size);
+				preparedFrame = Context->Frame;
+				prepared.push_back(this);
+			}
+			Rect ClientClip = GetClientRect().Intersection(clip);
+			for (auto control : Controls)
+				control->prepareCanvases(rb, fElapsedTime, ClientClip, prepared);
+		}
+		/* Render: How we draw!  This can be completely overridden, and each piece can be as well,
+		   DrawBackground, DrawCustom, and DrawText are called, in that order, and are all virtual and can be overridden */
+		friend class UIManager;
+		virtual void Render(RenderBackend* rb, float fElapsedTime, Rect clip)
+		{
+			if (Visible)
+			{
+				// if we dont intersect with the clip, or the clip or our size is 0 in both dimensions, dont bother!
+				Rect sRect = ScreenRect();
+				if (clip.Intersects(sRect) && !clip.IsEmpty() && !Location.IsEmpty())
+				{
+					if (!CanvasValid || mCanvas.Owner == NULL)
+					{
+						if (mCanvas.Owner == NULL || mCanvas.Size != Location.Size)
+							rb->CreateCanvas(mCanvas, Location.Size);
+						rb->BeginCanvas(mCanvas);
+						rb->Clear(olc::BLANK);
+						drawCanvas(rb, fElapsedTime);
+						rb->EndCanvas(mCanvas);
+						CanvasValid = true;
+					}
+
+					Rect ClientClip = GetClientRect(); // so we can adjust our clip as we go
+					drawTint = Tint == olc::WHITE ? inheritedTint : (inheritedTint == olc::WHITE ? Tint : Raster::Modulate(inheritedTint, Tint));
+
+					if (!clip.ContainsRect(sRect))
+					{
+						//clip here  // keep this note here so we can add scroll bar handling here!
+						olc::vi2d loc = sRect.Position;
+						olc::vi2d bounds = Location.Size;
+						int myright = loc.x + Location.Size.x;
+						int mybot = loc.y + Location.Size.y;
+						if (clip.right() < myright)
+							bounds.x -= myright - clip.right();
+						if (clip.bottom() < mybot)
+							bounds.y -= mybot - clip.bottom();
+						rb->DrawPartialCanvas(mCanvas, sRect.Position, { 0,0 }, bounds, drawTint);
+					}
+					else
+						rb->DrawCanvas(mCanvas, sRect.Position, drawTint);
+					DrawOverlay(rb, fElapsedTime, clip.Intersection(sRect));
+
+					ClientClip = ClientClip.Intersection(clip);
+					for (auto control : Controls)
+					{
+						control->inheritedTint = drawTint;
+						control->Render(rb, fElapsedTime, ClientClip);
+					}
+				}
+			}
+		}
+
+		/* GetClientRect: get the rectangle defined by the control, minus its padding. */
+		virtual Rect GetClientRect()
+		{
+			const ControlStyle& cs = Theme->GetStyle(Enabled, Hovering, Active);
+			Rect result;
+			result.Position = ScreenPos();
+			result.Size = Location.Size;
+			result.Position.x += cs.Padding.left;
+			result.Position.y += cs.Padding.top;
+			result.Size.x -= cs.Padding.horiz();
+			result.Size.y -= cs.Padding.vert();
+			return result;
+		}
+
+		/* DrawBackground: The basic draw background, which fills the control with BackgroundColor.
+			It will also draw BackgroundDecal if one is available, using the current scaling and alignment settings	*/
+		virtual void DrawBackground(RenderBackend* rb, float fElapsedTime)
+		{
+			if (Visible)
+			{
+				const ControlStyle& cs = Theme->GetStyle(Enabled, Hovering, Active);
+
+				if (cs.Background)
+				{
+					cs.Background->Render(rb, { {0,0}, Location.Size }, fElapsedTime);
+				}
+				if (cs.BorderType != RUI::BorderType::None)
+					UI::DrawBevel(rb, cs.BorderType, { {0,0},Location.Size });
+			}
+		}
+
+		/* DrawCustom: A layer to draw anything needed for custom controls, sits between the foreground and background. */
+		virtual void DrawCustom(RenderBackend* rb, float fElapsedTime) { }
+
+		/* DrawOverlay: drawn over the canvas each time it is composited, in screen coordinates with DrawQuad (overlayQuad clips for you).
+			For things that change too often to redraw the canvas for, like a caret.  Call InvalidateOverlay when it changes. */
+		virtual void DrawOverlay(RenderBackend* rb, float fElapsedTime, Rect clip) { }
+
+		/* overlayQuad: a quad in the overlay, clipped to clip */
+		void overlayQuad(RenderBackend* rb, Rect clip, olc::vi2d pos, olc::vi2d size, olc::Pixel p)
+		{
+			Rect area = Rect(pos, size).Intersection(clip);
+			if (!area.IsEmpty())
+				rb->DrawQuad(area.Position, area.Size, drawTint == olc::WHITE ? p : Raster::Modulate(p, drawTint));
+		}
+
+		/* DrawText: The text positioning and drawing layer, handles proper color, scaling, position. */
+		virtual void DrawText(RenderBackend* rb, float fElapsedTime)
+		{
+			if (Visible)
+			{
+				if (Text.length() > 0)
+				{
+					const ControlStyle& cs = Theme->GetStyle(Enabled, Hovering, Active);
+					const TextLayout& layout = layoutText(rb);
+					olc::vf2d spos = UI::AlignTextIn(layout.Size, { {cs.Padding.left,cs.Padding.right}, GetClientRect().Size }, cs.TextAlign, cs.TextScale);
+					rb->DrawTextLayout(spos, layout, cs.ForegroundColor, (uint32_t)cs.TextScale.x);
+				}
+			}
+		}
+	};
+
+	/* Ease: easing curves for animations, each maps t from 0 to 1 onto how far along the animation is */
+	class Ease
+	{
+	public:
+		static float Linear(float t) { return t; }
+		static float InQuad(float t) { return t * t; }
+		static float OutQuad(float t) { return t * (2 - t); }
+		static float InOutQuad(float t) { return t < 0.5f ? 2 * t * t : -1 + (4 - 2 * t) * t; }
+		static float InCubic(float t) { return t * t * t; }
+		static float OutCubic(float t) { float u = 1 - t; return 1 - u * u * u; }
+		static float InOutCubic(float t) { float u = -2 * t + 2; return t < 0.5f ? 4 * t * t * t : 1 - u * u * u / 2; }
+		/* OutBack: overshoots a little, then settles */
+		static float OutBack(float t) { const float c1 = 1.70158f, c3 = c1 + 1; float u = t - 1; return 1 + c3 * u * u * u + c1 * u * u; }
+	};
+
+	typedef float (*EaseFunction)(float);
+
+	/* AnimationId: identifies a running animation, to Stop it with.  0 is no animation. */
+	typedef uint32_t AnimationId;
+
+	/* Animator: runs animations of control positions, sizes and tints, and of anything else through a callback, from one place.
+		The UIManager has one (Animations) and ticks it once a frame; only animations that are running cost anything.
+		Moving a control reuses its canvas, and Fade changes its Tint, so neither redraws anything.  Resize has to redraw at each new size.
+		Animations start from wherever the control is when their delay is over, and replace any animation of the same property of it that was already running. */
+	class Animator
+	{
+	public:
+		/* Move: slide a control to a position, relative to its parent */
+		AnimationId Move(ControlBase* control, olc::vi2d to, float duration, EaseFunction ease = Ease::OutCubic, float delay = 0)
+		{
+			return add(control, PositionProperty, { (float)to.x, (float)to.y, 0, 0 }, duration, ease, delay);
+		}
+
+		/* Resize: grow or shrink a control to a size */
+		AnimationId Resize(ControlBase* control, olc::vi2d to, float duration, EaseFunction ease = Ease::OutCubic, float delay = 0)
+		{
+			return add(control, SizeProperty, { (float)to.x, (float)to.y, 0, 0 }, duration, ease, delay);
+		}
+
+		/* Fade: change a control's Tint, a to of olc::Pixel(255,255,255,0) fades it out */
+		AnimationId Fade(ControlBase* control, olc::Pixel to, float duration, EaseFunction ease = Ease::Linear, float delay = 0)
+		{
+			return add(control, TintProperty, { (float)to.r, (float)to.g, (float)to.b, (float)to.a }, duration, ease, delay);
+		}
+
+		/* Animate: call apply with how far along the animation is (eased, 0 to 1) every frame it runs.  For anything else, like a background color. */
+		AnimationId Animate(std::function<void(float)> apply, float duration, EaseFunction ease = Ease::Linear, float delay = 0)
+		{
+			AnimationId id = add(NULL, CustomProperty, { 0,0,0,0 }, duration, ease, delay);
+			tweens.back().Apply = apply;
+			return id;
+		}
+
+		/* OnFinished: call done when an animation finishes, not when it is stopped */
+		void OnFinished(AnimationId id, std::function<void()> done)
+		{
+			if (Tween* t = find(id))
+				t->Done = done;
+		}
+
+		/* Stop: stop an animation where it is, or at its end if finish is true.  Returns false if it wasn't running */
+		bool Stop(AnimationId id, bool finish = false)
+		{
+			Tween* t = find(id);
+			if (t == NULL)
+				return false;
+			size_t index = t - tweens.data(); // apply can start animations, and move tweens
+			if (finish)
+			{
+				if (!t->Started)
+					begin(*t);
+				apply(*t, 1);
+			}
+			tweens[index].Id = 0;
+			return true;
+		}
+
+		/* StopAll: stop every animation of a control */
+		void StopAll(ControlBase* control)
+		{
+			for (auto& t : tweens)
+				if (t.Target == control)
+					t.Id = 0;
+		}
+
+		/* IsRunning: the animation hasn't finished or been stopped yet, including while it waits for its delay */
+		bool IsRunning(AnimationId id) { return find(id) != NULL; }
+
+		/* IsAnimating: the control has an animation running */
+		bool IsAnimating(ControlBase* control)
+		{
+			for (auto& t : tweens)
+				if (t.Id != 0 && t.Target == control)
+					return true;
+			return false;
+		}
+
+		/* Active: the number of animations running */
+		size_t Active()
+		{
+			size_t count = 0;
+			for (auto& t : tweens)
+				count += t.Id != 0;
+			return count;
+		}
+
+		/* Tick: advance every running animation by fElapsedTime.  The UIManager calls this each Update, after handling input. */
+		void Tick(float fElapsedTime)
+		{
+			// animations started or stopped by callbacks are added to the end, or marked stopped, so indexes stay good
+			for (size_t i = 0; i < tweens.size(); i++)
+			{
+				if (tweens[i].Id == 0)
+					continue;
+				Tween& t = tweens[i];
+				t.Elapsed += fElapsedTime;
+				if (t.Elapsed < t.Delay)
+					continue;
+				if (!t.Started)
+					begin(t);
+				float progress = t.Duration > 0 ? std::min(1.0f, (t.Elapsed - t.Delay) / t.Duration) : 1.0f;
+				apply(tweens[i], progress);
+				if (progress >= 1.0f && tweens[i].Id != 0)
+				{
+					tweens[i].Id = 0;
+					std::function<void()> done = std::move(tweens[i].Done);
+					if (done != NULL)
+						done();
+				}
+			}
+			tweens.erase(std::remove_if(tweens.begin(), tweens.end(), [](const Tween& t) { return t.Id == 0; }), tweens.end());
+		}
+
+	private:
+		enum Property : uint8_t { PositionProperty, SizeProperty, TintProperty, CustomProperty };
+
+		struct Tween
+		{
+			AnimationId Id;
+			ControlBase* Target;
+			Property Prop;
+			bool Started;
+			float From[4];
+			float To[4];
+			float Delay;
+			float Duration;
+			float Elapsed;
+			EaseFunction Easing;
+			std::function<void(float)> Apply;
+			std::function<void()> Done;
+		};
+
+		std::vector<Tween> tweens;
+		AnimationId nextId = 1;
+
+		AnimationId add(ControlBase* control, Property prop, std::array<float, 4> to, float duration, EaseFunction ease, float delay)
+		{
+			Tween t;
+			t.Id = nextId++;
+			if (nextId == 0)
+				nextId = 1;
+			t.Target = control;
+			t.Prop = prop;
+			t.Started = false;
+			std::fill(t.From, t.From + 4, 0.0f);
+			std::copy(to.begin(), to.end(), t.To);
+			t.Delay = delay;
+			t.Duration = duration;
+			t.Elapsed = 0;
+			t.Easing = ease != NULL ? ease : Ease::Linear;
+			if (control != NULL)
+				markAnimated(control);
+			tweens.push_back(t);
+			return t.Id;
+		}
+
+		Tween* find(AnimationId id)
+		{
+			if (id == 0)
+				return NULL;
+			for (auto& t : tweens)
+				if (t.Id == id)
+					return &t;
+			return NULL;
+		}
+
+		/* begin: take the starting value, and stop anything else animating the same property */
+		void begin(Tween& t);
+		void apply(Tween& t, float progress);
+		void markAnimated(ControlBase* control);
+	};
+
+	inline void Animator::markAnimated(ControlBase* control)
+	{
+		control->animated = true;
+	}
+
+	inline void Animator::begin(Tween& t)
+	{
+		t.Started = true;
+		if (t.Target == NULL)
+			return;
+		for (auto& other : tweens)
+			if (&other != &t && other.Id != 0 && other.Started && other.Target == t.Target && other.Prop == t.Prop)
+				other.Id = 0;
+		switch (t.Prop)
+		{
+		case PositionProperty:
+		{
+			olc::vi2d pos = t.Target->Position();
+			t.From[0] = (float)pos.x;
+			t.From[1] = (float)pos.y;
+			break;
+		}
+		case SizeProperty:
+		{
+			olc::vi2d size = t.Target->Size();
+			t.From[0] = (float)size.x;
+			t.From[1] = (float)size.y;
+			break;
+		}
+		case TintProperty:
+		{
+			olc::Pixel tint = t.Target->GetTint();
+			t.From[0] = tint.r;
+			t.From[1] = tint.g;
+			t.From[2] = tint.b;
+			t.From[3] = tint.a;
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	inline void Animator::apply(Tween& t, float progress)
+	{
+		float e = t.Easing(progress);
+		auto lerp = [&](int i) { return t.From[i] + (t.To[i] - t.From[i]) * e; };
+		switch (t.Prop)
+		{
+		case PositionProperty:
+		{
+			olc::vi2d pos = { (int)std::lround(lerp(0)), (int)std::lround(lerp(1)) };
+			if (pos != t.Target->Position())
+				t.Target->SetPosition(pos);
+			break;
+		}
+		case SizeProperty:
+		{
+			olc::vi2d size = { std::max(0, (int)std::lround(lerp(0))), std::max(0, (int)std::lround(lerp(1))) };
+			if (size != t.Target->Size())
+				t.Target->SetSize(size);
+			break;
+		}
+		case TintProperty:
+		{
+			auto channel = [&](int i) { return (uint8_t)std::max(0L, std::min(255L, std::lround(lerp(i)))); };
+			t.Target->SetTint(olc::Pixel(channel(0), channel(1), channel(2), channel(3)));
+			break;
+		}
+		case CustomProperty:
+			if (t.Apply != NULL)
+			{
+				std::function<void(float)> apply = t.Apply; // t can move if the callback starts animations
+				apply(e);
+			}
+			break;
+		}
+	}
+
+	inline void ControlBase::stopAnimations()
+	{
+		if (Context != NULL && Context->Animations != NULL)
+			Context->Animations->StopAll(this);
+	}
+
+	/* Timeline: lays out a run of animations on an Animator, each starting with the ones before it (the default), at a time (At), or when they have all finished (Then):
+
+		 Timeline(ui->Animations)
+			.Move(panel, { 10,10 }, 0.3f)
+			.Fade(panel, olc::WHITE, 0.3f)
+			.Then()
+			.Move(button, { 20,40 }, 0.2f, Ease::OutBack);
+
+		The animations start as soon as they are added, with delays to keep them in order. */
+	class Timeline
+	{
+	public:
+		Timeline(Animator& animator) : animator(&animator) { }
+
+		Timeline& Move(ControlBase* control, olc::vi2d to, float duration, EaseFunction ease = Ease::OutCubic) { return added(animator->Move(control, to, duration, ease, start), duration); }
+		Timeline& Resize(ControlBase* control, olc::vi2d to, float duration, EaseFunction ease = Ease::OutCubic) { return added(animator->Resize(control, to, duration, ease, start), duration); }
+		Timeline& Fade(ControlBase* control, olc::Pixel to, float duration, EaseFunction ease = Ease::Linear) { return added(animator->Fade(control, to, duration, ease, start), duration); }
+		Timeline& Animate(std::function<void(float)> apply, float duration, EaseFunction ease = Ease::Linear) { return added(animator->Animate(apply, duration, ease, start), duration); }
+
+		/* Call: call done at this point of the timeline */
+		Timeline& Call(std::function<void()> done)
+		{
+			AnimationId id = animator->Animate([](float) {}, 0, Ease::Linear, start);
+			animator->OnFinished(id, done);
+			return added(id, 0);
+		}
+
+		/* Then: start what is added next once everything so far has finished, after gap seconds */
+		Timeline& Then(float gap = 0)
+		{
+			start = end + gap;
+			return *this;
+		}
+
+		/* At: start what is added next at a time from the start of the timeline */
+		Timeline& At(float time)
+		{
+			start = time;
+			return *this;
+		}
+
+		/* Duration: when the last animation so far finishes */
+		float Duration() { return end; }
+
+		/* Stop: stop every animation of the timeline that is still running */
+		void Stop()
+		{
+			for (AnimationId id : ids)
+				animator->Stop(id);
+			ids.clear();
+		}
+
+	private:
+		Animator* animator;
+		std::vector<AnimationId> ids;
+		float start = 0;
+		float end = 0;
+
+		Timeline& added(AnimationId id, float duration)
+		{
+			ids.push_back(id);
+			end = std::max(end, start + duration);
+			return *this;
+		}
+	};
+
+	/* DragHandle: a control that is used for a drag handler.  this allows an object to be moved based on dragging the handle around */
+	class DragHandle : public ControlBase
+	{
+	public:
+		ControlBase* DragControl = NULL;
+		olc::PixelGameEngine* pge;
+		Rect BoundingRectangle;
+
+		const char* TypeName() const override { return "DragHandle"; }
+
+		DragHandle(Rect location, ControlBase* parent, olc::PixelGameEngine* engine)
+			: ControlBase(location, parent)
+		{
+			pge = engine;
+		}
+
+		EventHandler OnDrag;
+
+		void Render(olc::PixelGameEngine* pge, float fElapsedTime)
+		{
+			return;
+		}
+
+		bool bDragging = false;
+		olc::vi2d mLoc;
+
+		void MouseDown(int mButton) override
+		{
+			bDragging = true;
+			mLoc = UI::MousePos;
+		}
+		void MouseUp(int mButton) override
+		{
+			bDragging = false;
+		}
+		void MouseEnter() override
+		{
+		}
+		void MouseLeave() override
+		{
+		}
+		void MouseMove() override
+		{
+			if (bDragging)
+			{
+				if (DragControl != NULL)
+				{
+
+					olc::vi2d cloc = UI::MousePos;
+
+					olc::vi2d pos = DragControl->Position();
+					olc::vi2d yopos = pos;
+					pos.x += (cloc.x - mLoc.x);
+					olc::vi2d xopos = pos;
+					pos.y += (cloc.y - mLoc.y);
+					yopos.y = pos.y;
+
+					if (BoundingRectangle.Size.x == 0 && BoundingRectangle.Size.y == 0) // if there is an empty rect
+					{
+						DragControl->SetPosition({ pos.x, pos.y });
+						mLoc = cloc;
+					}
+					else if (BoundingRectangle.ContainsRect({ pos,DragControl->Size() })) // if we are in the rect
+					{
+						DragControl->SetPosition({ pos.x, pos.y });
+						mLoc = cloc;
+					}
+					else if (BoundingRectangle.ContainsRect({ xopos,DragControl->Size() })) // try only moving x
+					{
+						DragControl->SetPosition({ xopos.x, xopos.y });
+						mLoc = cloc;
+					}
+					else if (BoundingRectangle.ContainsRect({ yopos,DragControl->Size() })) // try only moving y
+					{
+						DragControl->SetPosition({ yopos.x, yopos.y });
+						mLoc = cloc;
+					}
+					if (mLoc == cloc)
+						OnDrag.Invoke(this);
+				}
+			}
+		}
+	};
+
+	/* ResizeHandle: a control that is used for a resize handler.  this allows an object to be resized based on dragging the handle around */
+	class ResizeHandle : public ControlBase
+	{
+	public:
+		ControlBase* ResizeControl = NULL;
+		olc::PixelGameEngine* pge;
+
+		const char* TypeName() const override { return "ResizeHandle"; }
+
+		ResizeHandle(Rect location, ControlBase* parent, olc::PixelGameEngine* engine)
+			: ControlBase(location, parent)
+		{
+			pge = engine;
+		}
+
+		bool bSizing = false;
+		olc::vi2d mLoc;
+		olc::vi2d MinimumSize = { 30,30 };
+		olc::vi2d MaximumSize = { 0,0 };
+
+		void MouseDown(int mButton) override
+		{
+			bSizing = true;
+			mLoc = UI::MousePos;
+		}
+		void MouseUp(int mButton) override
+		{
+			bSizing = false;
+		}
+		void MouseEnter() override
+		{
+		}
+		void MouseLeave() override
+		{
+		}
+		void MouseMove() override
+		{
+			if (bSizing)
+			{
+				if (ResizeControl != NULL)
+				{
+					olc::vi2d cloc = UI::MousePos;
+					olc::vi2d sz = ResizeControl->Size();
+					int xamt = sz.x + (cloc.x - mLoc.x);
+					int yamt = sz.y + (cloc.y - mLoc.y);
+
+					if (xamt >= MinimumSize.x && (xamt < MaximumSize.x || MaximumSize.x == 0))
+						sz.x = xamt;
+					if (yamt >= MinimumSize.y && (yamt < MaximumSize.y || MaximumSize.y == 0))
+						sz.y = yamt;
+
+					ResizeControl->SetSize(sz.x, sz.y);
+					mLoc = cloc;
+				}
+			}
+		}
+	};
+
+	/* ListDataSource: where a ListControl gets its items, by index.  Implement it to list data you already have without copying it into strings. */
+	class ListDataSource
+	{
+	public:
+		virtual ~ListDataSource() {}
+
+		/* Count: how many items there are */
+		virtual int Count() = 0;
+		/* ItemText: the text to show for an item */
+		virtual std::string ItemText(int index) = 0;
+	};
+
+	/* VectorDataSource: a ListDataSource over a vector of strings, which is what ListControl::SetItems uses */
+	class VectorDataSource : public ListDataSource
+	{
+	public:
+		std::vector<std::string> Items;
+
+		int Count() override { return (int)Items.size(); }
+		std::string ItemText(int index) override { return Items[index]; }
+	};
+
+	/* ListIndex: a case insensitive index of a ListDataSource's items, for finding them by prefix (type-ahead) and by substring (filtering).
+		It keeps the lowercased text of every item and the items in sorted order, and is kept up to date item by item as the items change. */
+	class ListIndex
+	{
+	public:
+		/* Keys: the lowercased text of every item, by index */
+		std::vector<std::string> Keys;
+		/* Sorted: every item index, in order of their keys */
+		std::vector<int> Sorted;
+
+		/* Lower: the key for some text */
+		static std::string Lower(std::string text)
+		{
+			for (auto& c : text)
+				c = (char)tolower((unsigned char)c);
+			return text;
+		}
+
+		/* Build: index every item in source */
+		void Build(ListDataSource* source)
+		{
+			int count = source->Count();
+			Keys.resize(count);
+			Sorted.resize(count);
+			for (int i = 0; i < count; i++)
+			{
+				Keys[i] = Lower(source->ItemText(i));
+				Sorted[i] = i;
+			}
+			std::sort(Sorted.begin(), Sorted.end(), [this](int a, int b) { return less(a, b); });
+		}
+
+		/* Inserted: count items were inserted into source before index */
+		void Inserted(ListDataSource* source, int index, int count)
+		{
+			for (auto& item : Sorted)
+				if (item >= index)
+					item += count;
+			Keys.insert(Keys.begin() + index, count, std::string());
+			for (int i = index; i < index + count; i++)
+			{
+				Keys[i] = Lower(source->ItemText(i));
+				insertSorted(i);
+			}
+		}
+
+		/* Removed: count items starting at index were removed */
+		void Removed(int index, int count)
+		{
+			Sorted.erase(std::remove_if(Sorted.begin(), Sorted.end(), [&](int item) { return item >= index && item < index + count; }), Sorted.end());
+			for (auto& item : Sorted)
+				if (item >= index + count)
+					item -= count;
+			Keys.erase(Keys.begin() + index, Keys.begin() + index + count);
+		}
+
+		/* Changed: the text of count items starting at index changed in source */
+		void Changed(ListDataSource* source, int index, int count)
+		{
+			for (int i = index; i < index + count; i++)
+			{
+				Sorted.erase(std::lower_bound(Sorted.begin(), Sorted.end(), i, [this](int a, int b) { return less(a, b); }));
+				Keys[i] = Lower(source->ItemText(i));
+				insertSorted(i);
+			}
+		}
+
+		/* FindPrefix: the first item, in sorted order, whose key starts with prefix and that accept takes, or -1 */
+		template <class Accept>
+		int FindPrefix(const std::string& prefix, Accept accept) const
+		{
+			auto it = std::lower_bound(Sorted.begin(), Sorted.end(), prefix, [this](int item, const std::string& p) { return Keys[item] < p; });
+			for (; it != Sorted.end() && Keys[*it].compare(0, prefix.size(), prefix) == 0; ++it)
+				if (accept(*it))
+					return *it;
+			return -1;
+		}
+
+		/* Filter: the items whose key contains text, in item order.  If within is given only those items are looked at,
+			so typing one more letter of a filter only searches what the last one matched. */
+		void Filter(const std::string& text, const std::vector<int>* within, std::vector<int>& result) const
+		{
+			result.clear();
+			if (within != NULL)
+			{
+				for (auto item : *within)
+					if (Keys[item].find(text) != std::string::npos)
+						result.push_back(item);
+			}
+			else
+			{
+				for (int i = 0; i < (int)Keys.size(); i++)
+					if (Keys[i].find(text) != std::string::npos)
+						result.push_back(i);
+			}
+		}
+
+	private:
+		bool less(int a, int b) const
+		{
+			int c = Keys[a].compare(Keys[b]);
+			return c < 0 || (c == 0 && a < b);
+		}
+
+		void insertSorted(int item)
+		{
+			Sorted.insert(std::lower_bound(Sorted.begin(), Sorted.end(), item, [this](int a, int b) { return less(a, b); }), item);
+		}
+	};
+
+	/* ListControl: a derived and composite ControlBase that allows listbox like functionality.
+		It only has controls for the rows that fit on screen, and fills them from a ListDataSource as it scrolls, so it costs the same for ten items or ten million.
+		Typing while it has focus jumps to the first item starting with what was typed, and SetFilter shows only the items containing some text. */
+	class ListControl : public ControlBase
+	{
+	public:
+		/* SelectionChanged: A callback function to indicate that the selection of the list has changed */
+		std::function<void(ListControl*)> SelectionChanged;
+
+		/* ItemTheme: The theme for the items in the list (independant of the theme of the list), shared by every item. */
+		ThemeHandle ItemTheme;
+
+		/* EmptyTheme: EmptyTheme is a default theme that is used to draw any region of list that doesnt have an item available to draw */
+		ThemeHandle EmptyTheme;
+
+		const char* TypeName() const override { return "ListControl"; }
+
+		/* Constructor: Constructor to create and set ItemTheme */
+		ListControl(Rect location, ControlBase* parent)
+			: ControlBase(location, parent)
+		{
+			CanFocus = true;
+		}
+
+		/* Constructor: Constructor to create and set ItemTheme and configure a border. */
+		ListControl(Rect location, ControlBase* parent, const ThemeHandle& itemTheme)
+			: ControlBase(location, itemTheme, parent)
+		{
+			ItemTheme = itemTheme;
+			CanFocus = true;
+		}
+
+		~ListControl()
+		{
+			WaitForIndex();
+		}
+
+		/* ItemHeight: the height of each item in the list. */
+		int ItemHeight = 16;
+
+		/* BackgroundIndexSize: lists with at least this many items build their type-ahead and filter index on another thread */
+		int BackgroundIndexSize = 50000;
+
+		/* TypeAheadDelay: seconds without a key press before typing starts a new search */
+		float TypeAheadDelay = 1.0f;
+
+		/* SetItems: resets the items in the list.  It also resets any selection and scrolls to the top of the list. */
+		void SetItems(const std::vector<std::string>& items)
+		{
+			WaitForIndex();
+			ownItems.Items = items;
+			SetDataSource(&ownItems);
+		}
+		void SetItems(std::vector<std::string>&& items)
+		{
+			WaitForIndex();
+			ownItems.Items = std::move(items);
+			SetDataSource(&ownItems);
+		}
+
+		/* SetDataSource: list the items of source, which is not owned and must outlive the list (or be replaced first).
+			It resets any selection and filter, and scrolls to the top of the list. */
+		void SetDataSource(ListDataSource* source)
+		{
+			WaitForIndex();
+			Source = source;
+			TopIndex = 0; // reset position
+			SelectedIndex = -1;
+			filter.clear();
+			filtering = false;
+			if (indexState != IndexNone)
+			{
+				indexState = IndexNone;
+				buildIndex(); // it was in use, so keep it
+			}
+			if (SelectionChanged != NULL)
+				SelectionChanged(this);
+			createListItems();
+		}
+
+		/* DataSource: where the items come from, NULL if there are none */
+		ListDataSource* DataSource() { return Source; }
+
+		/* InsertItems: insert items before index (ItemCount to append), keeping the scroll position and selection on the items they were on.
+			Only for items given with SetItems, for a ListDataSource of your own change it and call ItemsInserted. */
+		void InsertItems(int index, const std::vector<std::string>& items)
+		{
+			WaitForIndex();
+			if (!ownsItems())
+				return;
+			index = std::max(0, std::min(index, ItemCount()));
+			ownItems.Items.insert(ownItems.Items.begin() + index, items.begin(), items.end());
+			ItemsInserted(index, (int)items.size());
+		}
+
+		/* RemoveRange: remove count items starting at index.  Removing the selected item clears the selection. */
+		void RemoveRange(int index, int count)
+		{
+			WaitForIndex();
+			if (!ownsItems())
+				return;
+			index = std::max(0, index);
+			count = std::min(count, ItemCount() - index);
+			if (count <= 0)
+				return;
+			ownItems.Items.erase(ownItems.Items.begin() + index, ownItems.Items.begin() + index + count);
+			ItemsRemoved(index, count);
+		}
+
+		/* UpdateItem: change the text of one item */
+		void UpdateItem(int index, const std::string& item)
+		{
+			WaitForIndex();
+			if (!ownsItems() || index < 0 || index >= ItemCount())
+				return;
+			ownItems.Items[index] = item;
+			ItemsChanged(index, 1);
+		}
+
+		/* ItemsInserted: count items were inserted into the data source before index */
+		void ItemsInserted(int index, int count)
+		{
+			if (count <= 0)
+				return;
+			WaitForIndex();
+			if (indexState == IndexReady)
+				index_.Inserted(Source, index, count);
+			rowsMoved(index);
+			int top = topItem();
+			if (SelectedIndex >= index)
+				SelectedIndex += count;
+			if (filtering)
+				refilter(top >= index ? top + count : top); // keep looking at the same items
+			else if (index < TopIndex)
+				TopIndex += count; // keep looking at the same items
+			else
+				refreshRows(index, ItemCount());
+		}
+
+		/* ItemsRemoved: count items starting at index were removed from the data source */
+		void ItemsRemoved(int index, int count)
+		{
+			if (count <= 0)
+				return;
+			WaitForIndex();
+			if (indexState == IndexReady)
+				index_.Removed(index, count);
+			rowsMoved(index);
+			int top = topItem();
+			bool lostSelection = false;
+			if (SelectedIndex >= index + count)
+				SelectedIndex -= count;
+			else if (SelectedIndex >= index)
+			{
+				SelectedIndex = -1;
+				lostSelection = true;
+			}
+
+			if (filtering)
+				refilter(top >= index + count ? top - count : std::min(top, index));
+			else if (TopIndex >= index + count)
+				TopIndex -= count; // keep looking at the same items
+			else
+			{
+				int top = TopIndex;
+				if (TopIndex > index)
+					TopIndex = index;
+				TopIndex = std::max(0, std::min(TopIndex, ItemCount() - 1));
+				refreshRows(TopIndex == top ? index : TopIndex, TopIndex + (int)ListItems.size());
+			}
+			if (lostSelection && SelectionChanged != NULL)
+				SelectionChanged(this);
+		}
+
+		/* ItemsChanged: the text of count items starting at index changed */
+		void ItemsChanged(int index, int count)
+		{
+			WaitForIndex();
+			if (indexState == IndexReady)
+				index_.Changed(Source, index, count);
+			if (filtering)
+				refilter(topItem());
+			else
+				refreshRows(index, index + count);
+		}
+
+		/* BeginUpdate: hold off refreshing rows until the matching EndUpdate, so many changes in a row only refresh once */
+		void BeginUpdate()
+		{
+			updateDepth++;
+		}
+
+		/* EndUpdate: refresh every row the changes since BeginUpdate touched, as far as it is still on screen */
+		void EndUpdate()
+		{
+			if (updateDepth == 0 || --updateDepth > 0)
+				return;
+			if (pendingFirst < pendingLast)
+				refreshRows(pendingFirst, pendingLast);
+			pendingFirst = INT_MAX;
+			pendingLast = INT_MIN;
+		}
+
+		/* ItemCount: the number of items in the list */
+		int ItemCount() { return Source == NULL ? 0 : Source->Count(); }
+
+		/* VisibleCount: the number of items that pass the filter, all of them when there isn't one */
+		int VisibleCount() { return filtering ? (int)filtered.size() : ItemCount(); }
+
+		/* GetSelection: returns the text of the selected item or an empty string if there is no selection. */
+		std::string GetSelection()
+		{
+			if (SelectedIndex < 0 || SelectedIndex >= ItemCount())
+				return "";
+			else
+				return Source->ItemText(SelectedIndex);
+		}
+
+		/* SetSelection: attempts to set the selection of the list to the Item that matches the item paramater.  This searches every item, prefer SetSelectedIndex. */
+		void SetSelection(std::string item)
+		{
+			int found = -1;
+			int count = ItemCount();
+			for (int i = 0; i < count; i++)
+			{
+				if (Source->ItemText(i) == item)
+				{
+					found = i;
+					break;
+				}
+			}
+			SetSelectedIndex(found);
+		}
+
+		/* SetSelectedIndex: select an item by its index, or -1 for no selection */
+		void SetSelectedIndex(int index)
+		{
+			if (index < -1 || index >= ItemCount())
+				index = -1;
+			int previous = SelectedIndex;
+			SelectedIndex = index;
+			refreshItem(previous);
+			refreshItem(index);
+			if (SelectionChanged != NULL)
+				SelectionChanged(this);
+		}
+
+		/* Scroll: scroll the list, in a positive or negative amt.  it is clamped at the first and list items in the current list. */
+		void Scroll(int amt)
+		{
+			TopIndex = std::max(0, std::min(TopIndex + amt, VisibleCount() - 1));
+			setItemText();
+		}
+
+		/* ScrollTo: scroll just far enough to show an item, if it passes the filter */
+		void ScrollTo(int index)
+		{
+			int row = rowOf(index);
+			if (row < 0)
+				return;
+			if (row < TopIndex)
+				TopIndex = row;
+			else if (row >= TopIndex + (int)ListItems.size())
+				TopIndex = row - (int)ListItems.size() + 1;
+			else
+				return;
+			setItemText();
+		}
+
+		/* CanScroll: are there items in the specificed direction that i cannot see?  parameter is true if UP or false if DOWN */
+		bool CanScroll(bool up)
+		{
+			if (up)
+				return TopIndex > 0;
+			else
+				return TopIndex < (VisibleCount() - 1);
+		}
+
+		/* GetTopIndex: the row at the top of the list, an item index when there is no filter */
+		int GetTopIndex() { return TopIndex; }
+
+		/* TypeAhead: select and show the first item, in sorted order, starting with prefix (ignoring case).  Returns false if none does. */
+		bool TypeAhead(const std::string& prefix)
+		{
+			std::string key = ListIndex::Lower(prefix);
+			int found = -1;
+			buildIndex();
+			if (indexState == IndexReady)
+				found = index_.FindPrefix(key, [this](int item) { return rowOf(item) >= 0; });
+			else
+			{
+				// still indexing, look through the items in order instead
+				int count = VisibleCount();
+				for (int row = 0; row < count && found < 0; row++)
+					if (ListIndex::Lower(Source->ItemText(itemOf(row))).compare(0, key.size(), key) == 0)
+						found = itemOf(row);
+			}
+			if (found < 0)
+				return false;
+			SetSelectedIndex(found);
+			ScrollTo(found);
+			return true;
+		}
+
+		/* SetFilter: only show the items containing text (ignoring case), or every item for "".  The selection is kept, and shown if it passes. */
+		void SetFilter(const std::string& text)
+		{
+			std::string key = ListIndex::Lower(text);
+			if (key == filter && (filtering || key.empty()))
+				return;
+			std::string previous = filter;
+			bool wasFiltering = filtering;
+			filter = key;
+			if (key.empty())
+			{
+				filtering = false;
+				TopIndex = 0;
+				setItemText();
+				ScrollTo(SelectedIndex);
+				return;
+			}
+			buildIndex();
+			if (indexState != IndexReady)
+				return; // applied when the index is ready
+
+			// a longer filter only matches what the shorter one did
+			bool narrower = wasFiltering && !previous.empty() && key.find(previous) != std::string::npos;
+			if (narrower)
+			{
+				std::vector<int> within;
+				within.swap(filtered);
+				index_.Filter(key, &within, filtered);
+			}
+			else
+				index_.Filter(key, NULL, filtered);
+			filtering = true;
+			TopIndex = 0;
+			setItemText();
+			ScrollTo(SelectedIndex);
+		}
+
+		/* GetFilter: the text items are being filtered by, lowercased */
+		const std::string& GetFilter() { return filter; }
+
+		/* Indexing: true while the index is being built on another thread */
+		bool Indexing() { return indexState == IndexBuilding; }
+
+		/* WaitForIndex: finish building the index, if it is being built.  Call it before changing a ListDataSource of your own,
+			the index thread reads items from it with ItemText. */
+		void WaitForIndex()
+		{
+			if (indexState != IndexBuilding)
+				return;
+			indexThread.join();
+			indexReady();
+		}
+
+		/* Update: make more or fewer rows when the list is resized, and pick up the index when its thread is done */
+		void Update(float fElapsedTime) override
+		{
+			if (indexState == IndexBuilding && indexDone)
+			{
+				indexThread.join();
+				indexReady();
+			}
+			if (GetClientRect().Size != rowArea)
+				createListItems();
+			typedTime += fElapsedTime;
+		}
+
+		/* HandleFocusInput: type-ahead, letters, numbers and spaces typed quickly enough are searched for together */
+		void HandleFocusInput(const InputState& input, float fElapsedTime) override
+		{
+			std::string typedChars;
+			for (const InputEvent& e : input.Events)
+			{
+				if (e.Type != InputEvent::KeyDown)
+					continue;
+				if (e.Code >= olc::Key::A && e.Code <= olc::Key::Z)
+					typedChars += (char)('a' + (e.Code - olc::Key::A));
+				else if (e.Code >= olc::Key::K0 && e.Code <= olc::Key::K9)
+					typedChars += (char)('0' + (e.Code - olc::Key::K0));
+				else if (e.Code == olc::Key::SPACE)
+					typedChars += ' ';
+			}
+			if (typedChars.empty())
+				return;
+
+			if (typedTime > TypeAheadDelay)
+				typed.clear();
+			typed += typedChars;
+			typedTime = 0;
+			TypeAhead(typed);
+		}
+
+	private:
+		/* setItemText: this redraws the text of each control created to match the current position in the list, as well as show the current selection */
+		void setItemText()
+		{
+			refreshRows(TopIndex, TopIndex + (int)ListItems.size());
+		}
+
+		/* itemOf, rowOf: convert between rows of the (filtered) list and item indices.  rowOf is -1 for items the filter hides. */
+		int itemOf(int row) { return filtering ? filtered[row] : row; }
+		int rowOf(int item)
+		{
+			if (item < 0 || !filtering)
+				return item;
+			auto it = std::lower_bound(filtered.begin(), filtered.end(), item);
+			return (it != filtered.end() && *it == item) ? (int)(it - filtered.begin()) : -1;
+		}
+
+		/* topItem: the item shown in the top row under a filter, -1 when there is none */
+		int topItem() { return filtering && TopIndex < (int)filtered.size() ? filtered[TopIndex] : -1; }
+
+		/* refreshItem: redraw the row showing an item, if it is on screen */
+		void refreshItem(int item)
+		{
+			int row = rowOf(item);
+			if (row >= 0)
+				refreshRows(row, row + 1);
+		}
+
+		/* rowsMoved: items from index on moved, so rows remembered since BeginUpdate past the first row showing them no longer show the same items; refresh every visible row instead */
+		void rowsMoved(int index)
+		{
+			int row = filtering ? (int)(std::lower_bound(filtered.begin(), filtered.end(), index) - filtered.begin()) : index;
+			if (updateDepth > 0 && pendingFirst < pendingLast && row < pendingLast)
+			{
+				pendingFirst = 0;
+				pendingLast = INT_MAX;
+			}
+		}
+
+		/* refreshRows: redraw the rows first to last (exclusive), if any are on screen.  Between BeginUpdate and EndUpdate it only remembers them. */
+		void refreshRows(int first, int last)
+		{
+			first = std::max(first, TopIndex);
+			last = std::min(last, TopIndex + (int)ListItems.size());
+			if (first >= last)
+				return;
+			if (updateDepth > 0)
+			{
+				pendingFirst = std::min(pendingFirst, first);
+				pendingLast = std::max(pendingLast, last);
+				return;
+			}
+
+			int count = VisibleCount();
+			for (int row = first; row < last; row++)
+			{
+				unsigned int i = (unsigned int)(row - TopIndex);
+				if (row < count)
+				{
+					int ridx = itemOf(row);
+					ListItems.at(i)->SetText(Source->ItemText(ridx));
+					ListItems.at(i)->Active = (ridx == SelectedIndex);
+					ListItems.at(i)->ApplyTheme(ItemTheme);
+				}
+				else
+				{
+					ListItems.at(i)->SetText("");
+					ListItems.at(i)->Active = false;
+					ListItems.at(i)->ApplyTheme(EmptyTheme);
+				}
+			}
+		}
+
+		/* Source: the items, ownItems when they came from SetItems */
+		ListDataSource* Source = NULL;
+		VectorDataSource ownItems;
+
+		/* ownsItems: whether the items are ours to change, adopting ownItems if there are none yet */
+		bool ownsItems()
+		{
+			if (Source == NULL)
+				Source = &ownItems;
+			return Source == &ownItems;
+		}
+
+		/* updateDepth: BeginUpdate nesting, and the rows to refresh when it gets back to 0 */
+		int updateDepth = 0;
+		int pendingFirst = INT_MAX;
+		int pendingLast = INT_MIN;
+
+		/* index_: the type-ahead and filter index, only built once one of them is used, and kept up to date from then on.
+			Big lists build it into building on indexThread. */
+		enum IndexState { IndexNone, IndexBuilding, IndexReady };
+		IndexState indexState = IndexNone;
+		ListIndex index_;
+		ListIndex* building = NULL;
+		std::thread indexThread;
+		std::atomic<bool> indexDone{ false };
+
+		/* buildIndex: start building the index, if it isn't built or being built */
+		void buildIndex()
+		{
+			if (indexState != IndexNone || Source == NULL)
+				return;
+			if (ItemCount() < BackgroundIndexSize)
+			{
+				index_.Build(Source);
+				indexState = IndexReady;
+				return;
+			}
+			building = new ListIndex();
+			indexDone = false;
+			indexState = IndexBuilding;
+			ListIndex* target = building;
+			ListDataSource* source = Source;
+			indexThread = std::thread([this, target, source]() {
+				target->Build(source);
+				indexDone = true;
+			});
+		}
+
+		/* indexReady: take the index the thread built, and apply any filter that was waiting for it */
+		void indexReady()
+		{
+			index_ = std::move(*building);
+			delete building;
+			building = NULL;
+			indexState = IndexReady;
+			if (!filter.empty() && !filtering)
+			{
+				std::string waiting = filter;
+				filter.clear();
+				SetFilter(waiting);
+			}
+		}
+
+		/* filter: the lowercased filter text, filtered the items passing it in order, while filtering */
+		std::string filter;
+		bool filtering = false;
+		std::vector<int> filtered;
+
+		/* refilter: the items changed under a filter, so find what passes it again, and scroll back to item top (or the first item after it that still passes) unless it is -1 */
+		void refilter(int top)
+		{
+			index_.Filter(filter, NULL, filtered);
+			if (top >= 0)
+				TopIndex = (int)(std::lower_bound(filtered.begin(), filtered.end(), top) - filtered.begin());
+			TopIndex = std::max(0, std::min(TopIndex, (int)filtered.size() - 1));
+			setItemText();
+		}
+
+		/* typed: what has been typed for type-ahead, and how long since the last key */
+		std::string typed;
+		float typedTime = 0;
+
+		/* TopIndex: the row that is currently the top of the visible items in the list, an item index when there is no filter. */
+		int TopIndex = 0; // our scroll position
+
+		/* ListItems: the row controls on the screen that display the visible part of the list, kept as long as the size of the list doesn't change */
+		std::vector<ControlBase*> ListItems;
+
+		/* rowArea: the client size the rows were laid out for */
+		olc::vi2d rowArea = { -1,-1 };
+
+		/* createListItems: lay the rows out to fill the client area, reusing the rows we have and only making or deleting the difference */
+		void createListItems()
+		{
+			Rect cr = GetClientRect();
+			rowArea = cr.Size;
+			int toDraw = std::max(0, cr.Size.y / ItemHeight);
+			while ((int)ListItems.size() > toDraw)
+			{
+				ControlBase* listItem = ListItems.back();
+				ListItems.pop_back();
+				Controls.remove(listItem);
+				if (ChildIndex != NULL)
+					ChildIndex->Remove(listItem);
+				delete listItem;
+			}
+
+			const ControlStyle& cs = Theme->GetStyle(Enabled, Hovering, Active);
+			for (int i = 0; i < toDraw; i++)
+			{
+				olc::vi2d loc = { cs.Padding.left, cs.Padding.top + (i * ItemHeight) };
+				olc::vi2d size = { cr.Size.x, ItemHeight };
+				if (i < (int)ListItems.size())
+				{
+					ListItems[i]->SetPosition(loc);
+					if (ListItems[i]->Size() != size)
+						ListItems[i]->SetSize(size);
+					continue;
+				}
+				ControlBase* listItem = new ControlBase({ loc,size }, ItemTheme, this);
+				ListItems.push_back(listItem); // the constructor already added it to Controls
+				listItem->Styled = false; // rows are the list's, themed by ItemTheme and EmptyTheme, not a StyleSheet
+				listItem->OnClick.Subscribe([this, i](ControlBase* control, int mButton) { ItemClicked(i); });
+			}
+			setItemText();
+		}
+
+	public:
+		/* SelectedIndex: the current index of the selection, IN Items, or -1 if no selection.  Use SetSelectedIndex to change it. */
+		int SelectedIndex = -1;
+
+	protected:
+		/* ItemClicked: Callback function to handle item selection, row is which of our rows was clicked */
+		void ItemClicked(int row)
+		{
+			row += TopIndex;
+			if (row < VisibleCount())
+				SetSelectedIndex(itemOf(row));
+		}
+
+		/* ItemAt: converts screen coordinates to an index into the items, or -1 if there isn't one there */
+		int ItemAt(olc::vi2d location)
+		{
+			Rect cr = GetClientRect();
+			if (location.x < cr.Position.x || location.y < cr.Position.y || location.x > cr.right() || location.y > cr.bottom())
+				return -1;
+			int visidx = ((location.y - cr.Position.y) / ItemHeight) + TopIndex;
+			return visidx < VisibleCount() ? itemOf(visidx) : -1;
+		}
+	};
+
+	/* InputRecording: the input of a run of frames, packed small enough to keep in memory or save to a file, and played back frame for frame.
+		Set UIManager::Recorder to record every frame the manager handles, then play it back headless, with the same elapsed times and events:
+
+		 InputState input;
+		 float fElapsedTime;
+		 while (recording.Next(fElapsedTime, input))
+			ui.Update(fElapsedTime, input);
+
+		Each frame is its elapsed time and its events, mouse moves stored as the distance from the last, so an idle frame is 5 bytes. */
+	class InputRecording
+	{
+	public:
+		/* Add: append a frame */
+		void Add(float fElapsedTime, const InputState& input)
+		{
+			uint32_t bits;
+			memcpy(&bits, &fElapsedTime, sizeof(bits));
+			for (int i = 0; i < 4; i++)
+				data.push_back((uint8_t)(bits >> (i * 8)));
+			writeNumber(input.Events.size());
+			for (const InputEvent& e : input.Events)
+			{
+				data.push_back((uint8_t)e.Type);
+				if (e.Type == InputEvent::MouseMove)
+				{
+					writeSigned(e.Pos.x - writeMouse.x);
+					writeSigned(e.Pos.y - writeMouse.y);
+					writeMouse = e.Pos;
+				}
+				else
+					writeNumber((uint32_t)e.Code);
+			}
+			frames++;
+		}
+
+		/* Next: play back the next frame into input, and its elapsed time.  Returns false at the end of the recording, or if it is corrupt */
+		bool Next(float& fElapsedTime, InputState& input)
+		{
+			if (readPos + 4 > data.size())
+				return false;
+			uint32_t bits = 0;
+			for (int i = 0; i < 4; i++)
+				bits |= (uint32_t)data[readPos++] << (i * 8);
+			memcpy(&fElapsedTime, &bits, sizeof(bits));
+			input.BeginFrame(fElapsedTime);
+
+			uint32_t count;
+			if (!readNumber(count))
+				return false;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				if (readPos >= data.size())
+					return false;
+				InputEvent e;
+				if (data[readPos] > InputEvent::KeyUp)
+					return false;
+				e.Type = (InputEvent::EventType)data[readPos++];
+				if (e.Type == InputEvent::MouseMove)
+				{
+					int32_t dx, dy;
+					if (!readSigned(dx) || !readSigned(dy))
+						return false;
+					readMouse += olc::vi2d(dx, dy);
+					e.Pos = readMouse;
+				}
+				else
+				{
+					uint32_t code;
+					if (!readNumber(code))
+						return false;
+					e.Code = (int)code;
+				}
+				input.Push(e);
+			}
+			return true;
+		}
+
+		/* Rewind: play back from the first frame again.  Play back into a fresh InputState too. */
+		void Rewind()
+		{
+			readPos = 0;
+			readMouse = { 0,0 };
+		}
+
+		/* Clear: forget every frame */
+		void Clear()
+		{
+			data.clear();
+			frames = 0;
+			writeMouse = { 0,0 };
+			Rewind();
+		}
+
+		/* Frames: the number of frames recorded, Bytes: how much space they take */
+		size_t Frames() const { return frames; }
+		size_t Bytes() const { return data.size(); }
+
+		/* Save: write the recording to a file, returns false if it couldn't be written */
+		bool Save(const std::string& path) const
 		{
-			OnMouseMove.Invoke(this);
-		};
+			std::ofstream file(path, std::ios::binary);
+			if (!file)
+				return false;
+			uint8_t header[12] = { 'R','U','I','R', version };
+			for (int i = 0; i < 4; i++)
+				header[8 + i] = (uint8_t)(frames >> (i * 8));
+			file.write((const char*)header, sizeof(header));
+			file.write((const char*)data.data(), data.size());
+			return (bool)file;
+		}
 
-		/* HandleFocusInput: Called during game update if you have input focus, so you can check for any keyboard atcivity */
-		virtual void HandleFocusInput(olc::PixelGameEngine* pge, float fElapsedTime) { }
+		/* Load: replace the recording with one from a file, returns false if it couldn't be read or isn't a recording */
+		bool Load(const std::string& path)
+		{
+			std::ifstream file(path, std::ios::binary);
+			uint8_t header[12];
+			if (!file.read((char*)header, sizeof(header)) || memcmp(header, "RUIR", 4) != 0 || header[4] != version)
+				return false;
+			Clear();
+			for (int i = 0; i < 4; i++)
+				frames |= (size_t)header[8 + i] << (i * 8);
+			data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+			return true;
+		}
 
-		/* Destructor: In case noone cleaned up the children before destroying the control */
-		~ControlBase()
+	private:
+		static const uint8_t version = 1;
+		std::vector<uint8_t> data;
+		size_t frames = 0;
+		size_t readPos = 0;
+		olc::vi2d writeMouse = { 0,0 };
+		olc::vi2d readMouse = { 0,0 };
+
+		/* writeNumber, writeSigned: 7 bits a byte, small numbers take one byte */
+		void writeNumber(uint32_t n)
 		{
-			for (auto control : Controls)
+			while (n >= 0x80)
 			{
-				try
-				{
-					delete control;
-				}
-				catch (...) {} // may not be our memory to clean, but dont want to leave it hanging if we are disappearing
+				data.push_back((uint8_t)(n | 0x80));
+				n >>= 7;
 			}
+			data.push_back((uint8_t)n);
 		}
-	protected:
-		/* ScreenPos: Our location in screen space */
-		olc::vi2d ScreenPos()
+
+		void writeSigned(int32_t n) { writeNumber(((uint32_t)n << 1) ^ (uint32_t)(n >> 31)); }
+
+		bool readNumber(uint32_t& n)
 		{
-			int x = 0;
-			int y = 0;
-			ControlBase* cb = this;
-			while (cb != NULL)
+			n = 0;
+			for (int shift = 0; shift < 35 && readPos < data.size(); shift += 7)
 			{
-				x += cb->Location.Position.x;
-				y += cb->Location.Position.y;
-				cb = cb->Parent;
+				uint8_t b = data[readPos++];
+				n |= (uint32_t)(b & 0x7f) << shift;
+				if ((b & 0x80) == 0)
+					return true;
 			}
-			return { x,y };
+			return false;
 		}
 
-		int GetStateVal()
+		bool readSigned(int32_t& n)
 		{
-			if (!Enabled)
-				return 3;
-			else if (Active)
-				return 2;
-			else if (Hovering)
-				return 1;
-			return 0;
+			uint32_t u;
+			if (!readNumber(u))
+				return false;
+			n = (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+			return true;
 		}
+	};
 
+	/* UIManager: my implementation of a UI management system, feel free to modify or use your own. */
+	class UIManager : public olc::PGEX
+	{
+	public:
+		/* Constructor: hook into the running olcPixelGameEngine, and draw with it */
+		UIManager()
+			: olc::PGEX(true)
+		{
+			Backend = new PGEBackend(olc::PGEX::pge);
+			ownsBackend = true;
+			mainControl = new ControlBase({ {0,0}, Backend->ScreenSize() });
+			mainControl->Context = &context;
+			context.Animations = &Animations;
+			context.Lists = &displayLists;
+		}
 
-		olc::Renderable mCanvas;
-		int lastStateVal = 0;;
-		/* Render: How we draw!  This can be completely overridden, and each piece can be as well,
-		   DrawBackground, DrawCustom, and DrawText are called, in that order, and are all virtual and can be overridden */
-		friend class UIManager;
-		virtual void Render(olc::PixelGameEngine* pge, float fElapsedTime, Rect clip)
+		/* Constructor: draw with the given backend, without hooking into an engine.  Call Update yourself each frame.
+		   The backend is not owned by the manager, and must outlive it. */
+		UIManager(RenderBackend* backend)
+			: olc::PGEX(false)
 		{
-			if (Visible)
-			{
-				ControlStyle cs = Theme.GetStyle(Enabled, Hovering, Active);
-				if (lastStateVal != GetStateVal())
-				{
-					Invalidate();
-					lastStateVal = GetStateVal();
-				}
-				// if we dont intersect with the clip, or the clip or our size is 0 in both dimensions, dont bother!
-				if (clip.Intersects({ ScreenPos(),Location.Size }) && !clip.IsEmpty() && !Location.IsEmpty())
-				{
-					if (!CanvasValid || mCanvas.Sprite() == NULL)
-					{
-						mCanvas.Create(Location.Size.x, Location.Size.y);
-						olc::Sprite* dtarget = pge->GetDrawTarget();
-						pge->SetDrawTarget(mCanvas.Sprite());
-						olc::Pixel::Mode pMode = pge->GetPixelMode();
-						//pge->SetPixelMode(olc::Pixel::ALPHA);
-						pge->SetPixelMode(UI::TrueAlpha);
-						pge->Clear(olc::BLANK);
-						DrawBackground(pge, fElapsedTime);
-						DrawCustom(pge, fElapsedTime);
-						DrawText(pge, fElapsedTime);
-						mCanvas.Decal()->Update();
-						pge->SetPixelMode(pMode);
-						pge->SetDrawTarget(dtarget);
-						CanvasValid = true;
-					}
+			Backend = backend;
+			mainControl = new ControlBase({ {0,0}, Backend->ScreenSize() });
+			mainControl->Context = &context;
+			context.Animations = &Animations;
+			context.Lists = &displayLists;
+		}
+	private:
+		bool ownsBackend = false;
+		DisplayListRecorder displayLists;
 
-					Rect ClientClip = GetClientRect(); // so we can adjust our clip as we go
+		/* workers: the threads canvases are rasterized on, started the first time there are enough to */
+		WorkerPool* workers = NULL;
+		std::vector<ControlBase*> prepared;
 
-					if (!clip.ContainsRect({ ScreenPos(),Location.Size }))
-					{
-						//clip here  // keep this note here so we can add scroll bar handling here!
-						olc::vi2d loc = ScreenPos();
-						olc::vi2d bounds = Location.Size;
-						int myright = loc.x + Location.Size.x;
-						int mybot = loc.y + Location.Size.y;
-						if (clip.right() < myright)
-						{
-							bounds.x -= (myright - clip.right()) + 1;
-							ClientClip.Size.x = bounds.x;
-						}
-						if (clip.bottom() < mybot)
-						{
-							bounds.y -= (mybot - clip.bottom()) + 1;
-							ClientClip.Size.y = bounds.y;
-						}
-						pge->DrawPartialDecal(ScreenPos(), mCanvas.Decal(), { 0,0 }, bounds);
-					}
-					else
-						pge->DrawDecal(ScreenPos(), mCanvas.Decal());
+		/* sortRaised: put the children raised since the last time back in z order, while nothing is iterating them */
+		void sortRaised()
+		{
+			for (auto control : context.Raised)
+				if (control != NULL)
+					control->Controls.Sort();
+			context.Raised.clear();
+		}
 
-					for (auto control : Controls)
-					{
-						control->Render(pge, fElapsedTime, ClientClip);
-					}
-				}
+		/* rasterizeCanvases: draw the canvases that need it in areas of the screen in parallel, if there are enough of them, and upload them.
+			Render then finds them drawn and only composites them. */
+		void rasterizeCanvases(const Rect* areas, size_t count, Rect screen, float fElapsedTime)
+		{
+			if (!ParallelCanvases || context.StaleCanvases < ParallelThreshold)
+				return;
+			if (workers == NULL)
+				workers = new WorkerPool(ParallelThreads);
+			if (workers->Workers() < 2 || !Backend->PrepareRasterize(workers->Workers()))
+				return; // with no threads to share it, drawing each canvas as it is composited is quicker
+			prepared.clear();
+			for (size_t i = 0; i < count; i++)
+			{
+				Rect area = areas[i];
+				mainControl->prepareCanvases(Backend, fElapsedTime, area.Intersection(screen), prepared);
+			}
+			if (prepared.size() < ParallelThreshold)
+				return; // Render will replay the lists just recorded
+
+			RenderBackend* backend = Backend;
+			workers->Run(prepared.size(), [this, backend](size_t item, size_t worker) {
+				ControlBase* control = prepared[item];
+				backend->RasterizeCanvas(control->mCanvas, *control->displayLists[control->GetStateVal()], worker);
+			});
+			for (auto control : prepared)
+			{
+				Backend->FinishCanvas(control->mCanvas, *control->displayLists[control->GetStateVal()]);
+				control->CanvasValid = true;
 			}
 		}
 
-		/* GetClientRect: get the rectangle defined by the control, minus its padding. */
-		virtual Rect GetClientRect()
+		void collectRecorded(ControlBase* control, std::vector<ControlBase*>& controls)
 		{
-			ControlStyle cs = Theme.GetStyle(Enabled, Hovering, Active);
-			Rect result;
-			result.Position = ScreenPos();
-			result.Size = Location.Size;
-			result.Position.x += cs.Padding.left;
-			result.Position.y += cs.Padding.top;
-			result.Size.x -= cs.Padding.horiz();
-			result.Size.y -= cs.Padding.vert();
-			return result;
+			if (control->GetDisplayList() != NULL)
+				controls.push_back(control);
+			for (auto child : control->Controls)
+				collectRecorded(child, controls);
 		}
 
-		/* DrawBackground: The basic draw background, which fills the control with BackgroundColor.
-			It will also draw BackgroundDecal if one is available, using the current scaling and alignment settings	*/
-		virtual void DrawBackground(olc::PixelGameEngine* pge, float fElapsedTime)
-		{
-			if (Visible)
-			{
-				ControlStyle cs = Theme.GetStyle(Enabled, Hovering, Active);
+		/* engineInput: the engine's input, kept from frame to frame for the held keys */
+		InputState engineInput;
 
-				if (cs.Background)
-				{
-					cs.Background->Render(pge, { {0,0}, Location.Size }, fElapsedTime);
-				}
-				if (cs.BorderType != RUI::BorderType::None)
-					UI::DrawBevel(pge, cs.BorderType, { {0,0},Location.Size });
-			}
+		/* pushButton: the events for a key or button the engine reports */
+		void pushButton(olc::HWButton button, InputEvent::EventType down, InputEvent::EventType up, int code)
+		{
+			if (button.bPressed)
+				engineInput.Push({ down, code });
+			if (button.bReleased)
+				engineInput.Push({ up, code });
 		}
 
-		/* DrawCustom: A layer to draw anything needed for custom controls, sits between the foreground and background. */
-		virtual void DrawCustom(olc::PixelGameEngine* pge, float fElapsedTime) { }
+		/* context: shared by every control in mainControl's tree */
+		UIContext context;
 
-		/* DrawText: The text positioning and drawing layer, handles proper color, scaling, position. */
-		virtual void DrawText(olc::PixelGameEngine* pge, float fElapsedTime)
+		/* composite: the whole ui as of the last frame, when Compositing */
+		Canvas composite;
+
+		/* curControl: the control, if any, the mouse is currently over */
+		ControlBase* curControl = NULL;
+
+		/* m_controls: a list of all of the controls that UIManager has been asked to manage, and clean up */
+		std::vector<ControlBase*> m_controls;
+
+		/* focusControl: The control that currently has input focus. */
+		ControlBase* focusControl = NULL;
+	public:
+		/* the control for the UI manager*/
+		ControlBase* mainControl;
+
+		/* Backend: what the UI draws with */
+		RenderBackend* Backend;
+
+		/* Compositing: keep the whole ui in one canvas, and only composite the areas controls report as changed.
+		   Far less work when little changes from frame to frame, at the cost of a screen sized canvas. */
+		bool Compositing = false;
+
+		/* ParallelCanvases: when ParallelThreshold or more canvases need drawing in a frame (a theme switch, say), draw them on a pool of threads
+		   from their display lists, then upload them on this thread.  Only with a backend that can (PrepareRasterize), and only canvases that record. */
+		bool ParallelCanvases = true;
+		size_t ParallelThreshold = 64;
+		/* ParallelThreads: the threads to draw on besides this one, 0 for one fewer than the hardware has.  Read when the pool is started. */
+		unsigned ParallelThreads = 0;
+
+		/* DeferEvents: queue OnMove, OnResize and Slider's OnValue, and raise them once per control per frame after input is handled.
+		   A drag that moves and resizes a window many times in a frame then only lays it out once. */
+		bool DeferEvents = false;
+
+		/* SetStyleSheet: theme the ui from a StyleSheet, or NULL to stop.  Controls restyle on the next update, and only the ones that look different redraw.
+		   The sheet is not owned by the manager, and must outlive it (or be unset first). */
+		void SetStyleSheet(StyleSheet* sheet) { context.Styles = sheet; }
+		StyleSheet* GetStyleSheet() { return context.Styles; }
+
+		/* FocusControl: The control that currently has input focus. */
+		ControlBase* FocusControl() { return focusControl; }
+
+		/* Descructor: clean up (or try) all of the controls you were managing. */
+		virtual ~UIManager()
 		{
-			if (Visible)
+			context.Damage.Enabled = false;
+			if (composite.Owner != NULL)
+				composite.Owner->FreeCanvas(composite);
+			for (auto control : mainControl->Controls)
 			{
-				if (Text.length() > 0)
+				try
 				{
-					ControlStyle cs = Theme.GetStyle(Enabled, Hovering, Active);
-					olc::vf2d spos = UI::AlignTextIn(pge, Text, { {cs.Padding.left,cs.Padding.right}, GetClientRect().Size }, cs.TextAlign, cs.TextScale);
-					UI::OutputText(pge, spos, GetClientRect().Size, Text, cs);
+					delete control;
 				}
+				catch (...) {}
 			}
+			if (ownsBackend)
+				delete Backend;
+			delete workers;
 		}
-	};
 
-	/* DragHandle: a control that is used for a drag handler.  this allows an object to be moved based on dragging the handle around */
-	class DragHandle : public ControlBase
-	{
-	public:
-		ControlBase* DragControl = NULL;
-		olc::PixelGameEngine* pge;
-		Rect BoundingRectangle;
+		/* lastmouse: the position of the mouse on the last draw call, to let us know if it moved. */
+		olc::vi2d lastmouse = { 0,0 };
 
-		DragHandle(Rect location, ControlBase* parent, olc::PixelGameEngine* engine)
-			: ControlBase(location, parent)
-		{
-			pge = engine;
-		}
+		/* mDownControl: the last control to get an mDownEvent */
+		ControlBase* mDownControl = NULL;
 
-		EventHandler OnDrag;
+		/* Recorder: when set, every frame Update handles is added to it, to be played back later.  Not owned by the manager. */
+		InputRecording* Recorder = NULL;
 
-		void Render(olc::PixelGameEngine* pge, float fElapsedTime)
+		/* Animations: the ui's animations, ticked each Update after input is handled */
+		Animator Animations;
+
+		/* CostliestControls: up to count controls whose recorded drawing (see GetDisplayList) touches the most pixels, costliest first.
+			For finding what is expensive to redraw, Describe a control's display list to see what it draws. */
+		std::vector<ControlBase*> CostliestControls(size_t count)
 		{
-			return;
+			std::vector<ControlBase*> controls;
+			collectRecorded(mainControl, controls);
+			auto pixels = [](ControlBase* control) { return control->GetDisplayList()->Pixels(); };
+			count = std::min(count, controls.size());
+			std::partial_sort(controls.begin(), controls.begin() + count, controls.end(), [&](ControlBase* a, ControlBase* b) { return pixels(a) > pixels(b); });
+			controls.resize(count);
+			return controls;
 		}
 
-		bool bDragging = false;
-		olc::vi2d mLoc;
-
-		void MouseDown(int mButton) override
+		/* OnBeforeUserUpdate: read the engine's input and update the ui, called by the engine before OnUserUpdate.
+			The engine's input is polled once here, into events for the frame, and controls only look at those. */
+		void OnBeforeUserUpdate(float& fElapsedTime) override
 		{
-			bDragging = true;
-			mLoc = pge->GetMousePos();
+			olc::PixelGameEngine* engine = olc::PGEX::pge;
+			engineInput.BeginFrame(fElapsedTime);
+			olc::vi2d mpos = engine->GetMousePos();
+			if (mpos != engineInput.MousePos)
+				engineInput.Push({ InputEvent::MouseMove, 0, mpos });
+			for (int i = 0; i < 3; i++)
+				pushButton(engine->GetMouse(i), InputEvent::MouseDown, InputEvent::MouseUp, i);
+			for (int k = olc::Key::NONE + 1; k < olc::Key::ENUM_END; k++)
+				pushButton(engine->GetKey((olc::Key)k), InputEvent::KeyDown, InputEvent::KeyUp, k);
+			Update(fElapsedTime, engineInput);
 		}
-		void MouseUp(int mButton) override
+
+		/* Update: the main update loop for the ui, handles the input and draws a frame. */
+		void Update(float fElapsedTime, const InputState& input)
 		{
-			bDragging = false;
+			if (Recorder != NULL)
+				Recorder->Add(fElapsedTime, input);
+			context.Events.Deferred = DeferEvents;
+			HandleInput(fElapsedTime, input);
+			Animations.Tick(fElapsedTime);
+			FlushEvents();
+			Render(fElapsedTime);
 		}
-		void MouseEnter() override
+
+		/* MaxEventRounds: how many times FlushEvents goes round while handlers keep raising events, the rest wait for the next frame */
+		int MaxEventRounds = 8;
+
+		/* FlushEvents: raise the events queued while DeferEvents is set, once per control with its latest values.  Update calls it after handling input. */
+		void FlushEvents()
 		{
+			EventQueue& events = context.Events;
+			for (int round = 0; round < MaxEventRounds && !events.Pending.empty(); round++)
+			{
+				events.Flushing.swap(events.Pending);
+				for (size_t i = 0; i < events.Flushing.size(); i++)
+				{
+					ControlBase* control = events.Flushing[i];
+					if (control == NULL)
+						continue;
+					uint32_t raised = control->raisedEvents;
+					control->raisedEvents = 0;
+					control->dispatchEvents(raised);
+				}
+				events.Flushing.clear();
+			}
 		}
-		void MouseLeave() override
+
+		/* Render: draw a frame of the ui through the Backend. */
+		void Render(float fElapsedTime)
 		{
+			Rect screen = { {0,0},Backend->ScreenSize() };
+			context.Damage.Enabled = Compositing;
+			context.Frame++;
+			sortRaised();
+			mainControl->UpdateTree(fElapsedTime);
+			sortRaised(); // Update may have raised some
+
+			Backend->BeginFrame();
+			if (Compositing)
+			{
+				if (composite.Owner == NULL || composite.Size != screen.Size)
+				{
+					Backend->CreateCanvas(composite, screen.Size);
+					context.Damage.Clear();
+					context.Damage.Add(screen);
+				}
+				if (!context.Damage.Rects.empty())
+				{
+					rasterizeCanvases(context.Damage.Rects.data(), context.Damage.Rects.size(), screen, fElapsedTime);
+					for (auto& area : context.Damage.Rects)
+					{
+						Rect clip = area.Intersection(screen);
+						if (clip.IsEmpty())
+							continue;
+						Backend->BeginComposite(composite, clip);
+						mainControl->Render(Backend, fElapsedTime, clip);
+					}
+					Backend->EndComposite(composite);
+					context.Damage.Clear();
+				}
+				Backend->DrawCanvas(composite, { 0,0 });
+			}
+			else
+			{
+				if (composite.Owner != NULL)
+					composite.Owner->FreeCanvas(composite);
+				rasterizeCanvases(&screen, 1, screen, fElapsedTime);
+				mainControl->Render(Backend, fElapsedTime, screen);
+			}
+			context.StaleCanvases = 0;
+			Backend->EndFrame();
 		}
-		void MouseMove() override
+
+		/* HandleInput: update hover state, and dispatch the mouse and focus input for a frame. */
+		void HandleInput(float fElapsedTime, const InputState& input)
 		{
-			if (bDragging)
+			sortRaised();
+			olc::vi2d mpos = input.MousePos;
+			UI::MousePos = mpos;
+
+			if (mpos != lastmouse)
 			{
-				if (DragControl != NULL)
+				lastmouse = mpos;
+				if (mDownControl != NULL)
 				{
+					mDownControl->MouseMove();
+				}
+			}
 
-					olc::vi2d cloc = pge->GetMousePos();
 
-					olc::vi2d pos = DragControl->Position();
-					olc::vi2d yopos = pos;
-					pos.x += (cloc.x - mLoc.x);
-					olc::vi2d xopos = pos;
-					pos.y += (cloc.y - mLoc.y);
-					yopos.y = pos.y;
+			if (curControl && curControl->Hovering)
+				curControl->Hovering = false; // we will set it in the next call anyway, just makes sure we dont get "stuck" hovers
 
-					if (BoundingRectangle.Size.x == 0 && BoundingRectangle.Size.y == 0) // if there is an empty rect
-					{
-						DragControl->SetPosition({ pos.x, pos.y });
-						mLoc = cloc;
-					}
-					else if (BoundingRectangle.ContainsRect({ pos,DragControl->Size() })) // if we are in the rect
+			ControlBase* nControl = NULL;
+
+			nControl = mainControl->MouseOver(mpos);
+			if (nControl != curControl)
+			{
+				if (curControl != NULL)
+					curControl->MouseLeave();
+				curControl = nControl;
+				if (nControl != NULL)
+					nControl->MouseEnter();
+			}
+			else
+			{
+				curControl = nControl;
+			}
+
+			if (focusControl != NULL)
+			{
+				focusControl->HandleFocusInput(input, fElapsedTime);
+			}
+
+			for (int i = 0; i < 3; i++)
+			{
+				if (input.Mouse[i].bPressed)
+				{
+					if (curControl != NULL)
 					{
-						DragControl->SetPosition({ pos.x, pos.y });
-						mLoc = cloc;
+						// mDown event
+						curControl->MouseDown(i);
+						curControl->PopToTop();
+
+						mDownControl = curControl;
 					}
-					else if (BoundingRectangle.ContainsRect({ xopos,DragControl->Size() })) // try only moving x
+					if (focusControl != NULL)
 					{
-						DragControl->SetPosition({ xopos.x, xopos.y });
-						mLoc = cloc;
+						focusControl->Blur();
 					}
-					else if (BoundingRectangle.ContainsRect({ yopos,DragControl->Size() })) // try only moving y
+					focusControl = NULL;
+
+					if (curControl != NULL)
 					{
-						DragControl->SetPosition({ yopos.x, yopos.y });
-						mLoc = cloc;
+						// the control, or the nearest control it is part of that can take focus
+						ControlBase* focusable = curControl;
+						while (focusable != NULL && !focusable->CanFocus)
+							focusable = focusable->Parent;
+						if (focusable != NULL)
+						{
+							focusControl = focusable;
+							focusControl->Focus();
+						}
+
+						curControl->OnClick.Invoke(curControl, i);
 					}
-					if (mLoc == cloc)
-						OnDrag.Invoke(this);
+
+				}
+				else if (input.Mouse[i].bReleased)
+				{
+					if (mDownControl != NULL)
+						mDownControl->MouseUp(i);
+
+					mDownControl = NULL;
 				}
 			}
 		}
+
+		/* CreateControl: use this to create a default control and add it to the parent at the specified location. */
+		ControlBase* CreateControl(Rect location, ControlBase* parent = NULL)
+		{
+			ControlBase* result = new ControlBase(location, parent);
+			m_controls.push_back(result);
+			return result;
+		}
+
+		/* CreateControl: use this to create a themed control and add it to the parent at the specified location. */
+		ControlBase* CreateControl(Rect location, const ThemeHandle& theme, ControlBase* parent = NULL)
+		{
+			ControlBase* result = CreateControl(location, parent);
+			result->ApplyTheme(theme);
+			m_controls.push_back(result);
+			return result;
+		}
+
+		/* AddControl: Add a custom control, or precreated control, that derives from ControlBase. */
+		void AddControl(ControlBase* control)
+		{
+			m_controls.push_back(control);
+		}
 	};
 
-	/* ResizeHandle: a control that is used for a resize handler.  this allows an object to be resized based on dragging the handle around */
-	class ResizeHandle : public ControlBase
+	/* GapBuffer: text with a gap at the edit position, so typing and deleting where the last edit was is O(1) however long the text is.
+		Moving the edit position costs the distance moved. */
+	class GapBuffer
 	{
 	public:
-		ControlBase* ResizeControl = NULL;
-		olc::PixelGameEngine* pge;
+		/* Length: the number of characters, not counting the gap */
+		size_t Length() const { return data.size() - (gapEnd - gapStart); }
 
-		ResizeHandle(Rect location, ControlBase* parent, olc::PixelGameEngine* engine)
-			: ControlBase(location, parent)
+		char At(size_t i) const { return i < gapStart ? data[i] : data[i + (gapEnd - gapStart)]; }
+
+		/* Insert: insert count characters before pos */
+		void Insert(size_t pos, const char* text, size_t count)
 		{
-			pge = engine;
+			moveGap(std::min(pos, Length()));
+			reserve(count);
+			std::copy(text, text + count, data.begin() + gapStart);
+			gapStart += count;
 		}
+		void Insert(size_t pos, char c) { Insert(pos, &c, 1); }
 
-		bool bSizing = false;
-		olc::vi2d mLoc;
-		olc::vi2d MinimumSize = { 30,30 };
-		olc::vi2d MaximumSize = { 0,0 };
-
-		void MouseDown(int mButton) override
+		/* Erase: remove count characters starting at pos */
+		void Erase(size_t pos, size_t count)
 		{
-			bSizing = true;
-			mLoc = pge->GetMousePos();
+			if (pos >= Length())
+				return;
+			moveGap(pos);
+			gapEnd += std::min(count, data.size() - gapEnd);
 		}
-		void MouseUp(int mButton) override
+
+		/* Assign: replace all of the text */
+		void Assign(const std::string& text)
 		{
-			bSizing = false;
+			data.assign(text.begin(), text.end());
+			gapStart = gapEnd = data.size();
 		}
-		void MouseEnter() override
+
+		/* Substr: count characters starting at pos, as a string */
+		std::string Substr(size_t pos, size_t count) const
 		{
+			std::string result;
+			pos = std::min(pos, Length());
+			count = std::min(count, Length() - pos);
+			result.reserve(count);
+			for (size_t i = pos; i < pos + count; i++)
+				result += At(i);
+			return result;
 		}
-		void MouseLeave() override
+
+		std::string ToString() const
 		{
+			std::string result;
+			result.reserve(Length());
+			result.append(data.begin(), data.begin() + gapStart);
+			result.append(data.begin() + gapEnd, data.end());
+			return result;
 		}
-		void MouseMove() override
-		{
-			if (bSizing)
-			{
-				if (ResizeControl != NULL)
-				{
-					olc::vi2d cloc = pge->GetMousePos();
-					olc::vi2d sz = ResizeControl->Size();
-					int xamt = sz.x + (cloc.x - mLoc.x);
-					int yamt = sz.y + (cloc.y - mLoc.y);
 
-					if (xamt >= MinimumSize.x && (xamt < MaximumSize.x || MaximumSize.x == 0))
-						sz.x = xamt;
-					if (yamt >= MinimumSize.y && (yamt < MaximumSize.y || MaximumSize.y == 0))
-						sz.y = yamt;
+	private:
+		std::vector<char> data;
+		size_t gapStart = 0;
+		size_t gapEnd = 0;
 
-					ResizeControl->SetSize(sz.x, sz.y);
-					mLoc = cloc;
-				}
+		void moveGap(size_t pos)
+		{
+			if (pos < gapStart)
+			{
+				size_t n = gapStart - pos;
+				std::copy_backward(data.begin() + pos, data.begin() + gapStart, data.begin() + gapEnd);
+				gapStart -= n;
+				gapEnd -= n;
+			}
+			else if (pos > gapStart)
+			{
+				size_t n = pos - gapStart;
+				std::copy(data.begin() + gapEnd, data.begin() + gapEnd + n, data.begin() + gapStart);
+				gapStart += n;
+				gapEnd += n;
 			}
 		}
+
+		/* reserve: make the gap at least count long, growing it with the text so appends stay amortized O(1) */
+		void reserve(size_t count)
+		{
+			size_t gap = gapEnd - gapStart;
+			if (gap >= count)
+				return;
+			size_t extra = std::max(count - gap, data.size() / 2 + 16);
+			data.insert(data.begin() + gapEnd, extra, 0);
+			gapEnd += extra;
+		}
 	};
 
-	/* ListControl: a derived and composite ControlBase that allows listbox like functionality. */
-	class ListControl : public ControlBase
+	/* LineIndex: where every line of a text starts, kept up to date as the text is edited.
+		Lines before the last edit are kept as offsets from the start of the text, and lines after it as offsets from the end,
+		so an edit only touches the lines between it and the last one, not every line after it. */
+	class LineIndex
 	{
 	public:
-		/* SelectionChanged: A callback function to indicate that the selection of the list has changed */
-		std::function<void(ListControl*)> SelectionChanged;
-
-		/* ItemTheme: The theme for the items in the list (independant of the theme of the list). */
-		ControlTheme ItemTheme;
-
-		/* EmptyTheme: EmptyTheme is a default theme that is used to draw any region of list that doesnt have an item available to draw */
-		ControlTheme EmptyTheme;
-
-		/* Constructor: Constructor to create and set ItemTheme */
-		ListControl(Rect location, ControlBase* parent)
-			: ControlBase(location, parent)
-		{
-		}
+		LineIndex() { Reset(""); }
 
-		/* Constructor: Constructor to create and set ItemTheme and configure a border. */
-		ListControl(Rect location, ControlBase* parent, ControlTheme itemTheme)
-			: ControlBase(location, itemTheme, parent)
+		/* Reset: index a whole new text */
+		void Reset(const std::string& text)
 		{
-			ItemTheme = itemTheme;
+			length = text.length();
+			before.assign(1, 0);
+			after.clear();
+			for (size_t i = 0; i < text.length(); i++)
+				if (text[i] == '\n')
+					before.push_back(i + 1);
 		}
 
-		/* ItemHeight: the height of each item in the list. */
-		int ItemHeight = 16;
+		/* Count: the number of lines, at least 1 */
+		size_t Count() const { return before.size() + after.size(); }
 
-		/* SetItems: resets the items in the list.  It also resets any selection and scrolls to the top of the list. */
-		void SetItems(std::vector<std::string> items)
+		/* Start: where line starts in the text */
+		size_t Start(size_t line) const
 		{
-			for (auto control : Controls)
-			{
-				try { delete control; }
-				catch (...) {} // not managed by ui manager!
-			}
-			Controls.clear();
-
-			Items = items;
-			TopIndex = 0; // reset position
-			SelectedIndex = -1;
-			if (SelectionChanged != NULL)
-				SelectionChanged(this);
-			createListItems();
+			if (line < before.size())
+				return before[line];
+			return length - after[after.size() - 1 - (line - before.size())];
 		}
 
-		/* GetSelection: returns the text of the selected item or an empty string if there is no selection. */
-		std::string GetSelection()
+		/* End: where line ends, at its line break or the end of the text */
+		size_t End(size_t line) const
 		{
-			if (SelectedIndex == -1)
-				return "";
-			else
-				return Items.at(SelectedIndex);
+			return line + 1 < Count() ? Start(line + 1) - 1 : length;
 		}
 
-		/* SetSelection: attempts to set the selection of the list to the Item that matches the item paramater. */
-		void SetSelection(std::string item)
+		/* LineOf: the line pos is on */
+		size_t LineOf(size_t pos) const
 		{
-			SelectedIndex = -1;
-			for (unsigned int i = 0; i < Items.size(); i++)
-			{
-				if (Items[i].compare(item) == 0)
-				{
-					SelectedIndex = i;
-					break;
-				}
-			}
-			setItemText();
-			if (SelectionChanged != NULL)
-				SelectionChanged(this);
+			if (after.empty() || pos < length - after.back())
+				return (std::upper_bound(before.begin(), before.end(), pos) - before.begin()) - 1;
+			// after is in reverse, so the line pos is on is the one starting the least distance from the end at or before pos
+			size_t i = std::lower_bound(after.begin(), after.end(), length - pos) - after.begin();
+			return before.size() + (after.size() - 1 - i);
 		}
 
-		/* Scroll: scroll the list, in a positive or negative amt.  it is clamped at the first and list items in the current list. */
-		void Scroll(int amt)
+		/* Inserted: count characters of text were inserted at pos */
+		void Inserted(size_t pos, const char* text, size_t count)
 		{
-			TopIndex = std::min(std::max(0, TopIndex + amt), ((int)Items.size()) - 1);
-			setItemText();
+			split(pos);
+			length += count;
+			for (size_t i = 0; i < count; i++)
+				if (text[i] == '\n')
+					before.push_back(pos + i + 1);
 		}
 
-		/* CanScroll: are there items in the specificed direction that i cannot see?  parameter is true if UP or false if DOWN */
-		bool CanScroll(bool up)
+		/* Erased: count characters were removed at pos */
+		void Erased(size_t pos, size_t count)
 		{
-			if (up)
-				return TopIndex >= 0;
-			else
-				return TopIndex < ((int)Items.size() - 1);
+			split(pos);
+			while (!after.empty() && length - after.back() <= pos + count)
+				after.pop_back(); // the line breaks that were removed
+			length -= count;
 		}
 
 	private:
-		/* setItemText: this redraws the text of each control created to match the current position in the list, as well as show the current selection */
-		void setItemText()
+		size_t length = 0;
+		std::vector<size_t> before;
+		std::vector<size_t> after; // distances from the end, the first line after the split last
+
+		/* split: move lines so those starting at or before pos are in before, and the rest in after */
+		void split(size_t pos)
 		{
-			for (unsigned int i = 0; i < ListItems.size(); i++)
+			while (before.size() > 1 && before.back() > pos)
 			{
-				unsigned int ridx = i + TopIndex;
-				if (ridx < Items.size())
-				{
-					ListItems.at(i)->SetText(Items.at(ridx));
-					ListItems.at(i)->Active = (ridx == SelectedIndex);
-					ListItems.at(i)->ApplyTheme(ItemTheme);
-				}
-				else
-				{
-					ListItems.at(i)->ApplyTheme(EmptyTheme);
-				}
+				after.push_back(length - before.back());
+				before.pop_back();
+			}
+			while (!after.empty() && length - after.back() <= pos)
+			{
+				before.push_back(length - after.back());
+				after.pop_back();
 			}
 		}
+	};
 
-		/* Items: the collection of strings that make up the list. */
-		std::vector<std::string> Items;
+	/* TextEdit : a simplified single line text entry field.  Check UI::TypedKeys for list of supported keys.
+		The text is kept in a GapBuffer with a caret and a selection, and only the part that fits in the control is laid out and drawn. */
+	class TextEdit : public ControlBase
+	{
+	private:
+		/* focused: is the control currently focused? */
+		bool focused = false;
 
-		/* TopIndex: the index that is currently the top of the visible items in the list. */
-		int TopIndex = 0; // our scroll position
+		/* Alpha: Current alpha value for the flasher */
+		int Alpha = 0;
 
-		/* ListItems: the controls on the screen that display the current selection of Items */
-		std::vector<ControlBase*> ListItems;
+		/* Factor: Current direction the alpha channel is moving */
+		int Factor = 1;
 
-		/* createListItems: this recreates all of the controls that are used for the display after the list changes */
-		void createListItems()
+		/* Pace: The speed at which the pulse occurs.  Pace * fElapsedTime is added or subtracted from the alpha of the background until it reaches the limit, then changes direction */
+		int Pace = 900;
+
+		/* buffer: the text being edited.  Text is only brought up to date with it when GetText asks. */
+		GapBuffer buffer;
+		bool textStale = false;
+
+		/* caret: where typing goes, anchor: the other end of the selection, the same as caret when nothing is selected */
+		size_t caret = 0;
+		size_t anchor = 0;
+
+		/* scrollFirst: the first character shown, kept so the caret is always in view */
+		size_t scrollFirst = 0;
+
+		/* textX, textY: where the first shown character was drawn, in the canvas, for placing the caret and selection */
+		int textX = 0;
+		int textY = 0;
+
+		/* visibleLayout: the layout of the characters that were shown */
+		std::shared_ptr<const TextLayout> visibleLayout;
+
+	public:
+		std::function<void(ControlBase*, std::string)> OnTextChanged;
+
+		/* CursorColor: the color of the text entry cursor */
+		olc::Pixel CursorColor = olc::BLACK;
+
+		/* SelectionColor: drawn over selected text */
+		olc::Pixel SelectionColor = olc::Pixel(0, 120, 215, 96);
+
+		const char* TypeName() const override { return "TextEdit"; }
+
+		/* Constructor: Basic default constructor */
+		TextEdit(Rect location, ControlBase* parent) : ControlBase(location, parent)
 		{
-			// clean up!
-			ListItems.clear();
-			Rect cr = GetClientRect();
-			int toDraw = cr.Size.y / ItemHeight;
-			for (int i = 0; i < toDraw; i++)
-			{
-				ControlStyle cs = Theme.GetStyle(Enabled, Hovering, (SelectedIndex == TopIndex + toDraw));
-				olc::vi2d loc = { cs.Padding.left, cs.Padding.top + (i * ItemHeight) };
-				olc::vi2d size = { cr.Size.x, ItemHeight };
-				ControlBase* listItem = new ControlBase({ loc,size }, ItemTheme, this);
-				ListItems.push_back(listItem);
-				Controls.push_back(listItem);
-				itemClickedBind = std::bind(&ListControl::ItemClicked, this, std::placeholders::_1, std::placeholders::_2);
-				listItem->OnClick.Subscribe(itemClickedBind);
-			}
-			setItemText();
+			CanFocus = true;
 		}
 
-		/* SelectedIndex: the current index of the selection, IN Items, or -1 if no selection. */
-		int SelectedIndex = -1;
-
-	protected:
-		std::function<void(ControlBase*, int)> itemClickedBind;
-		/* ItemClicked: Callback function to handle item selection */
-		void ItemClicked(ControlBase* control, int mButton)
+		/* GetText: the text, put together from the edit buffer if it changed */
+		std::string GetText() override
 		{
-			std::string tofind = control->GetText();
-			for (unsigned int i = 0; i < Items.size(); i++)
+			if (textStale)
 			{
-				if (Items.at(i).compare(tofind) == 0)
-				{
-					SelectedIndex = i;
-					if (SelectionChanged != NULL)
-						SelectionChanged(this);
-				}
+				Text = buffer.ToString();
+				textStale = false;
 			}
-			setItemText(); // handles selection display as well
+			return Text;
 		}
 
-		/* ItemAt: converts screen coordinates to an index into Items */
-		int ItemAt(olc::vi2d location)
+		/* SetText: replace the text, with the caret at the end */
+		void SetText(std::string val) override
 		{
-			Rect cr = GetClientRect();
-			if (location.x < cr.Position.x || location.y < cr.Position.y || location.x > cr.right() || location.y > cr.bottom())
-				return -1;
-			int visidx = ((location.y - cr.Position.y) / ItemHeight) + TopIndex;
+			if (!textStale && Text == val)
+				return;
+			Text = val;
+			textStale = false;
+			buffer.Assign(val);
+			caret = anchor = buffer.Length();
+			scrollFirst = 0;
+			scrollToCaret();
+			Invalidate();
 		}
-	};
 
-	/* UIManager: my implementation of a UI management system, feel free to modify or use your own. */
-	class UIManager : public olc::PGEX
-	{
-	public:
-		UIManager()
-			: olc::PGEX(true)
+		/* Length: the number of characters in the text */
+		size_t Length() const { return buffer.Length(); }
+
+		/* GetCaret: where the caret is, as a character index */
+		size_t GetCaret() const { return caret; }
+
+		/* SetCaret: move the caret, extending the selection from where it was if select is true, or clearing it otherwise */
+		void SetCaret(size_t pos, bool select = false)
 		{
-			mainControl = new ControlBase({ {0,0}, {olc::PGEX::pge->ScreenWidth(),olc::PGEX::pge->ScreenHeight()} });
+			pos = std::min(pos, buffer.Length());
+			if (pos == caret && (select || anchor == caret))
+				return;
+			caret = pos;
+			if (!select)
+				anchor = caret;
+			size_t first = scrollFirst;
+			scrollToCaret();
+			if (scrollFirst != first)
+				Invalidate();
+			else
+				InvalidateOverlay(); // the text didn't move, only the caret and selection
 		}
-	private:
-		/* curControl: the control, if any, the mouse is currently over */
-		ControlBase* curControl = NULL;
 
-		/* m_controls: a list of all of the controls that UIManager has been asked to manage, and clean up */
-		std::vector<ControlBase*> m_controls;
+		/* Select: select the characters from start to end, with the caret at end */
+		void Select(size_t start, size_t end)
+		{
+			anchor = std::min(start, buffer.Length());
+			SetCaret(end, true);
+		}
 
-		/* focusControl: The control that currently has input focus. */
-		ControlBase* focusControl = NULL;
-	public:
-		/* the control for the UI manager*/
-		ControlBase* mainControl;
+		/* SelectionStart, SelectionEnd: the selected characters, the same when nothing is */
+		size_t SelectionStart() const { return std::min(caret, anchor); }
+		size_t SelectionEnd() const { return std::max(caret, anchor); }
 
-		/* FocusControl: The control that currently has input focus. */
-		ControlBase* FocusControl() { return focusControl; }
+		/* GetSelectedText: the selected text, "" if nothing is selected */
+		std::string GetSelectedText() const { return buffer.Substr(SelectionStart(), SelectionEnd() - SelectionStart()); }
 
-		/* Descructor: clean up (or try) all of the controls you were managing. */
-		~UIManager()
+		/* Insert: insert text at the caret, replacing any selection, as if it was pasted.  Line breaks are dropped. */
+		void Insert(const std::string& text)
 		{
-			for (auto control : mainControl->Controls)
+			deleteSelection();
+			for (char c : text)
 			{
-				try
+				if (c == '\n' || c == '\r')
+					continue;
+				buffer.Insert(caret++, c);
+			}
+			anchor = caret;
+			textChanged();
+		}
+
+		/* TypeChar: edit the text as if a character was typed at the caret, 0x08 is backspace and 0x7f delete.  Returns true if Text changed */
+		bool TypeChar(char c)
+		{
+			if (c == 0x08 || c == 0x7f)
+			{
+				if (!deleteSelection())
 				{
-					delete control;
+					if (c == 0x08)
+					{
+						if (caret == 0)
+							return false;
+						buffer.Erase(--caret, 1);
+					}
+					else
+					{
+						if (caret == buffer.Length())
+							return false;
+						buffer.Erase(caret, 1);
+					}
+					anchor = caret;
 				}
-				catch (...) {}
 			}
+			else
+			{
+				deleteSelection();
+				buffer.Insert(caret++, c);
+				anchor = caret;
+			}
+			textChanged();
+			return true;
 		}
 
-		/* lastmouse: the position of the mouse on the last draw call, to let us know if it moved. */
-		olc::vi2d lastmouse = { 0,0 };
+	protected:
 
-		/* mDownControl: the last control to get an mDownEvent */
-		ControlBase* mDownControl = NULL;
+		void Update(float fElapsedTime) override
+		{
+			adjustFlasher(fElapsedTime);
+		}
 
-		/* UpdateUI: the main update loop for the ui, to be called by OnUserUpdate in the game loop. */
-		void OnBeforeUserUpdate(float& fElapsedTime) override
+		/* HandleFocusInput: overridden to handle all text input and the editing of the string within the text box */
+		void HandleFocusInput(const InputState& input, float fElapsedTime) override
 		{
-			olc::vi2d mpos = olc::PGEX::pge->GetMousePos();
+			appendInput(input);
+		}
 
-			if (mpos != lastmouse)
+		/* MouseDown: put the caret under the mouse */
+		void MouseDown(int mButton) override
+		{
+			ControlBase::MouseDown(mButton);
+			const ControlStyle& cs = Theme->GetStyle(Enabled, Hovering, Active);
+			int scale = std::max(1, (int)cs.TextScale.x);
+			int x = (UI::MousePos.x - ScreenPos().x - textX) / scale;
+			size_t pos = scrollFirst;
+			for (int width = 0; pos < buffer.Length(); pos++)
 			{
-				lastmouse = mpos;
-				if (mDownControl != NULL)
-				{
-					mDownControl->MouseMove();
-				}
+				int advance = TextLayout::Advance(buffer.At(pos));
+				if (width + advance / 2 > x)
+					break;
+				width += advance;
 			}
+			SetCaret(pos);
+		}
 
+		/* DrawText: overridden to draw the characters in view */
+		void DrawText(RenderBackend* rb, float fElapsedTime) override
+		{
+			layoutVisible(rb);
+			const ControlStyle& cs = Theme->GetStyle(Enabled, Hovering, Active);
+			if (visibleLayout->Text.length() > 0)
+				rb->DrawTextLayout({ textX, textY }, *visibleLayout, cs.ForegroundColor, (uint32_t)std::max(1, (int)cs.TextScale.x));
+		}
 
-			if (curControl && curControl->Hovering)
-				curControl->Hovering = false; // we will set it in the next call anyway, just makes sure we dont get "stuck" hovers
-
-			ControlBase* nControl = NULL;
+		/* layoutState: the state visibleLayout, textX and textY were worked out for.  A canvas replayed from a display list for another state doesn't work them out again */
+		int layoutState = -1;
 
-			nControl = mainControl->MouseOver(mpos);
-			if (nControl != curControl)
+		/* layoutVisible: lay out the characters that fit, and where they go */
+		void layoutVisible(RenderBackend* rb)
+		{
+			Rect pos = GetClientRect();
+			const ControlStyle& cs = Theme->GetStyle(Enabled, Hovering, Active);
+			int scale = std::max(1, (int)cs.TextScale.x);
+			layoutState = GetStateVal();
+
+			// only the characters that fit are laid out
+			std::string shown;
+			int room = pos.Size.x / scale;
+			for (size_t i = scrollFirst, width = 0; i < buffer.Length() && (int)width < room; i++)
 			{
-				if (curControl != NULL)
-					curControl->MouseLeave();
-				curControl = nControl;
-				nControl->MouseEnter();
+				char c = buffer.At(i);
+				shown += c;
+				width += TextLayout::Advance(c);
 			}
-			else
+			if (visibleLayout == NULL || visibleLayout->Text != shown)
+				visibleLayout = rb->LayoutText(shown);
+			const TextLayout& layout = *visibleLayout;
+
+			olc::vi2d off = { cs.Padding.left,cs.Padding.top };
+			olc::vi2d size = { std::max(layout.Size.x, 8), 8 };
+			olc::vf2d textpos = UI::AlignTextIn(size, { off,pos.Size }, cs.TextAlign, cs.TextScale);
+			textX = (int)textpos.x;
+			textY = (int)textpos.y;
+		}
+
+		/* DrawOverlay: the selection and the caret, so neither redraws the canvas as they change */
+		void DrawOverlay(RenderBackend* rb, float fElapsedTime, Rect clip) override
+		{
+			if (visibleLayout == NULL || (!focused && SelectionEnd() == SelectionStart()))
+				return;
+			if (layoutState != GetStateVal())
+				layoutVisible(rb);
+			const ControlStyle& cs = Theme->GetStyle(Enabled, Hovering, Active);
+			int scale = std::max(1, (int)cs.TextScale.x);
+			const TextLayout& layout = *visibleLayout;
+			olc::vi2d origin = ScreenPos();
+			auto charX = [&](size_t index) { return origin.x + textX + layout.CharPos[std::min(index - scrollFirst, layout.Text.length())].x * scale; };
+
+			if (SelectionEnd() > SelectionStart() && SelectionEnd() > scrollFirst)
 			{
-				curControl = nControl;
+				int x0 = charX(std::max(SelectionStart(), scrollFirst));
+				int x1 = charX(SelectionEnd());
+				overlayQuad(rb, clip, { x0, origin.y + textY }, { x1 - x0, 8 * (int)cs.TextScale.y }, SelectionColor);
 			}
+			if (focused)
+				overlayQuad(rb, clip, { charX(caret), origin.y + cs.Padding.top + 2 }, { 2, GetClientRect().Size.y - 4 }, olc::Pixel(CursorColor.r, CursorColor.g, CursorColor.b, Alpha));
+		}
 
-			if (focusControl != NULL)
+		/* appendInput: check for any keys and type them if there are any pressed that we care about, returns a bool indicating if any input caused Text to change */
+		bool appendInput(const InputState& input)
+		{
+			bool changed = false;
+			bool shifted = input.Shifted();
+			for (char c : UI::TypedKeys(input))
+				changed |= TypeChar(c);
+			if (input.Key(olc::Key::DEL).bPressed)
+				changed |= TypeChar(0x7f);
+
+			// caret movement, extending the selection with shift
+			if (input.Key(olc::Key::LEFT).bPressed)
 			{
-				focusControl->HandleFocusInput(olc::PGEX::pge, fElapsedTime);
+				if (!shifted && anchor != caret)
+					SetCaret(SelectionStart()); // collapse the selection to its start
+				else
+					SetCaret(caret > 0 ? caret - 1 : 0, shifted);
 			}
-
-			mainControl->Render(olc::PGEX::pge, fElapsedTime, { {0,0},{pge->ScreenWidth(),pge->ScreenHeight()} });
-
-			for (int i = 0; i < 3; i++)
+			if (input.Key(olc::Key::RIGHT).bPressed)
 			{
-				if (olc::PGEX::pge->GetMouse(i).bPressed)
-				{
-					if (curControl != NULL)
-					{
-						// mDown event
-						curControl->MouseDown(i);
-						curControl->PopToTop();
-
-						mDownControl = curControl;
-					}
-					if (focusControl != NULL)
-					{
-						focusControl->Blur();
-					}
-					focusControl = NULL;
-
-					if (curControl != NULL)
-					{
-						if (curControl->CanFocus)
-						{
-							focusControl = curControl;
-							focusControl->Focus();
-						}
+				if (!shifted && anchor != caret)
+					SetCaret(SelectionEnd());
+				else
+					SetCaret(caret + 1, shifted);
+			}
+			if (input.Key(olc::Key::HOME).bPressed)
+				SetCaret(0, shifted);
+			if (input.Key(olc::Key::END).bPressed)
+				SetCaret(buffer.Length(), shifted);
+			return changed;
+		}
 
-						curControl->OnClick.Invoke(curControl, i);
-					}
+		/* deleteSelection: remove the selected text, if any, returns true if there was some */
+		bool deleteSelection()
+		{
+			if (caret == anchor)
+				return false;
+			size_t start = SelectionStart();
+			buffer.Erase(start, SelectionEnd() - start);
+			caret = anchor = start;
+			return true;
+		}
 
-				}
-				else if (olc::PGEX::pge->GetMouse(i).bReleased)
-				{
-					if (mDownControl != NULL)
-						mDownControl->MouseUp(i);
+		/* textChanged: the buffer was edited */
+		void textChanged()
+		{
+			textStale = true;
+			scrollToCaret();
+			Invalidate();
+			if (OnTextChanged != NULL)
+				OnTextChanged(this, GetText());
+		}
 
-					mDownControl = NULL;
-				}
+		/* scrollToCaret: scroll as little as possible to keep the caret in view, and fill any room on the right by showing more on the left.
+			Only looks at the characters around the view, so it costs the same for any length of text. */
+		void scrollToCaret()
+		{
+			const ControlStyle& cs = Theme->GetStyle(Enabled, Hovering, Active);
+			int scale = std::max(1, (int)cs.TextScale.x);
+			int room = (GetClientRect().Size.x - 4) / scale; // leave room for the caret
+			size_t length = buffer.Length();
+			scrollFirst = std::min(scrollFirst, caret);
+
+			// the caret past the right edge, walk back from it as far as fits
+			int width = 0;
+			size_t first = caret;
+			while (first > scrollFirst && width + TextLayout::Advance(buffer.At(first - 1)) <= room)
+				width += TextLayout::Advance(buffer.At(--first));
+			if (first > scrollFirst)
+			{
+				scrollFirst = first;
+				return;
 			}
+
+			// room left after the end of the text, show more from before scrollFirst
+			width = 0;
+			for (size_t i = scrollFirst; i < length && width <= room; i++)
+				width += TextLayout::Advance(buffer.At(i));
+			while (scrollFirst > 0 && width + TextLayout::Advance(buffer.At(scrollFirst - 1)) <= room)
+				width += TextLayout::Advance(buffer.At(--scrollFirst));
 		}
 
-		/* CreateControl: use this to create a default control and add it to the parent at the specified location. */
-		ControlBase* CreateControl(Rect location, ControlBase* parent = NULL)
+		/* adjustFlasher: updates the pulse of the cursor */
+		void adjustFlasher(float fElapsedTime)
 		{
-			ControlBase* result = new ControlBase(location, parent);
-			m_controls.push_back(result);
-			return result;
+			int cur_alpha = Alpha;
+			int amt = (int)(Pace * fElapsedTime);
+			int a = Alpha + (amt * Factor);
+			if (a > 255)
+			{
+				a = 255;
+				Factor *= -1;
+			}
+			else if (a < 0)
+			{
+				a = 0;
+				Factor *= -1;
+			}
+			Alpha = a;
+			if (cur_alpha != a && focused) // the cursor is only drawn while focused
+				InvalidateOverlay();
 		}
 
-		/* CreateControl: use this to create a themed control and add it to the parent at the specified location. */
-		ControlBase* CreateControl(Rect location, ControlTheme theme, ControlBase* parent = NULL)
+		/* Focus: overridden to handle focus */
+		void Focus() override
 		{
-			ControlBase* result = CreateControl(location, parent);
-			result->ApplyTheme(theme);
-			m_controls.push_back(result);
-			return result;
+			focused = true;
+			InvalidateOverlay();
 		}
 
-		/* AddControl: Add a custom control, or precreated control, that derives from ControlBase. */
-		void AddControl(ControlBase* control)
+		/* Blur: overridden to handle focus */
+		void Blur() override
 		{
-			m_controls.push_back(control);
+			focused = false;
+			InvalidateOverlay();
 		}
 	};
 
-	/* TextEdit : a simplified text entry field.  Check keyList for list of supported keys. */
-	class TextEdit : public ControlBase
+	/* TextArea: a multi line text box, for viewing and editing longer text like config files and logs.
+		The text is kept in a GapBuffer with a LineIndex, and only the lines in view are laid out and drawn, so a 100k line text costs the same to draw and edit as a short one. */
+	class TextArea : public ControlBase
 	{
-	private:
-		/* focused: is the control currently focused? */
-		bool focused = false;
+	public:
+		std::function<void(ControlBase*)> OnTextChanged;
 
-		/* keylist: the keys we monitor for input */
-		olc::Key keyList[41] = {
-									olc::Key::A,olc::Key::B,olc::Key::C,olc::Key::D,olc::Key::E,olc::Key::F,olc::Key::G,olc::Key::H,olc::Key::I,olc::Key::J,
-									olc::Key::K,olc::Key::L,olc::Key::M,olc::Key::N,olc::Key::O,olc::Key::P,olc::Key::Q,olc::Key::R,olc::Key::S,olc::Key::T,
-									olc::Key::U,olc::Key::V,olc::Key::W,olc::Key::X,olc::Key::Y,olc::Key::Z,
-									olc::Key::K0,olc::Key::K1,olc::Key::K2,olc::Key::K3,olc::Key::K4,olc::Key::K5,olc::Key::K6,olc::Key::K7,olc::Key::K8,olc::Key::K9,
-									olc::Key::SPACE, olc::Key::PERIOD, olc::Key::MINUS, olc::Key::COMMA, olc::Key::BACK
-		};
+		/* CursorColor: the color of the caret */
+		olc::Pixel CursorColor = olc::BLACK;
 
-		/* keyValues: the values of the keyList in characters, first set is shifted, second set is unshifted */
-		char keyValues[82] = {
-									'A','B','C','D','E','F','G','H','I','J','K','L','M','N','O','P','Q','R','S','T','U','V','W','X','Y','Z',
-									')','!','@','#','$','%','^','&','*','(',
-									' ','>','-', '<', 0x08,
-									'a','b','c','d','e','f','g','h','i','j','k','l','m','n','o','p','q','r','s','t','u','v','w','x','y','z',
-									'0','1','2','3','4','5','6','7','8','9',
-									' ','.','-', ',', 0x08
-		};
+		/* SelectionColor: drawn over selected text */
+		olc::Pixel SelectionColor = olc::Pixel(0, 120, 215, 96);
 
-		/* Alpha: Current alpha value for the flasher */
-		int Alpha = 0;
+		/* ReadOnly: the text can be scrolled and selected but not edited by the user */
+		bool ReadOnly = false;
 
-		/* Factor: Current direction the alpha channel is moving */
-		int Factor = 1;
+		const char* TypeName() const override { return "TextArea"; }
 
-		/* Pace: The speed at which the pulse occurs.  Pace * fElapsedTime is added or subtracted from the alpha of the background until it reaches the limit, then changes direction */
-		int Pace = 900;
+		TextArea(Rect location, ControlBase* parent) : ControlBase(location, parent)
+		{
+			CanFocus = true;
+			Theme.Edit().Default.TextAlign = { RUI::Alignment::Near, RUI::Alignment::Near };
+		}
 
-	public:
-		std::function<void(ControlBase*, std::string)> OnTextChanged;
+		/* GetText: the whole text, put together from the edit buffer if it changed */
+		std::string GetText() override
+		{
+			if (textStale)
+			{
+				Text = buffer.ToString();
+				textStale = false;
+			}
+			return Text;
+		}
 
-		/* CursorColor: the color of the text entry cursor */
-		olc::Pixel CursorColor = olc::BLACK;
+		/* SetText: replace the text, with the caret and scroll position at the start */
+		void SetText(std::string val) override
+		{
+			Text = val;
+			textStale = false;
+			buffer.Assign(val);
+			lines.Reset(val);
+			caret = anchor = 0;
+			TopLine = 0;
+			Invalidate();
+		}
 
-		/* Constructor: Basic default constructor */
-		TextEdit(Rect location, ControlBase* parent) : ControlBase(location, parent)
+		/* Length: the number of characters in the text */
+		size_t Length() const { return buffer.Length(); }
+
+		/* LineCount: the number of lines in the text */
+		size_t LineCount() const { return lines.Count(); }
+
+		/* GetLine: the text of a line, without its line break */
+		std::string GetLine(size_t line) const
 		{
-			CanFocus = true;
+			if (line >= lines.Count())
+				return "";
+			return buffer.Substr(lines.Start(line), lines.End(line) - lines.Start(line));
 		}
 
-	protected:
+		/* LineStart: where a line starts in the text, LineOf: the line a character is on */
+		size_t LineStart(size_t line) const { return lines.Start(std::min(line, lines.Count() - 1)); }
+		size_t LineOf(size_t pos) const { return lines.LineOf(std::min(pos, buffer.Length())); }
 
-		void Render(olc::PixelGameEngine* pge, float fElapsedTime, Rect clip) override
+		/* TopLine: the first line in view */
+		size_t TopLine = 0;
+
+		/* VisibleLines: how many whole lines fit in the control */
+		int VisibleLines()
 		{
-			adjustFlasher(fElapsedTime); 
-			ControlBase::Render(pge, fElapsedTime, clip);
+			const ControlStyle& cs = Theme->GetStyle(Enabled, Hovering, Active);
+			return std::max(1, GetClientRect().Size.y / lineHeight(cs));
 		}
 
-		/* DrawText: overridden to handle all text input and the editing of the string within the text box */
-		void DrawText(olc::PixelGameEngine* pge, float fElapsedTime) override
+		/* ScrollLines: scroll up (negative) or down a number of lines */
+		void ScrollLines(int amt)
 		{
-			Rect pos = GetClientRect();
-			ControlStyle cs = Theme.GetStyle(Enabled, Hovering, Active);
-			if (!focused)
+			long long top = (long long)TopLine + amt;
+			top = std::max(0LL, std::min(top, (long long)lines.Count() - 1));
+			if ((size_t)top != TopLine)
 			{
-				ControlBase::DrawText(pge, fElapsedTime);
+				TopLine = (size_t)top;
+				Invalidate();
 			}
+		}
+
+		/* GetCaret: where the caret is, as a character index */
+		size_t GetCaret() const { return caret; }
+
+		/* SetCaret: move the caret and scroll it into view, extending the selection from where it was if select is true */
+		void SetCaret(size_t pos, bool select = false)
+		{
+			pos = std::min(pos, buffer.Length());
+			if (pos == caret && (select || anchor == caret))
+				return;
+			caret = pos;
+			if (!select)
+				anchor = caret;
+			column = caret - lines.Start(lines.LineOf(caret));
+			size_t top = TopLine;
+			scrollToCaret();
+			if (TopLine != top)
+				Invalidate();
 			else
-			{
-				bool changed = appendInput(pge);
-				if (changed && OnTextChanged != NULL)
-					OnTextChanged(this, Text);
+				InvalidateOverlay(); // the text didn't move, only the caret and selection
+		}
 
-				if (Text.length() == 0)
-				{
-					pge->FillRect({ pos.Position.x + 3, pos.Position.y + 2 }, { 2,pos.Size.y - 4 }, olc::Pixel(CursorColor.r, CursorColor.g, CursorColor.b, Alpha));
-				}
-				else
-				{
-					olc::vi2d negsize = pge->GetTextSize("WW"); // use this to determine when we have less than 2 characters 
-					negsize = { (int)(negsize.x * cs.TextScale.x),(int)(negsize.y * cs.TextScale.y) };
-					olc::vi2d size = pge->GetTextSize(Text);
-					size = { (int)(size.x * cs.TextScale.x), (int)(size.y * cs.TextScale.y) };
-					std::string displaytext = Text;
-					int maxsize = pos.Size.x - negsize.x;
+		/* Select: select the characters from start to end, with the caret at end */
+		void Select(size_t start, size_t end)
+		{
+			anchor = std::min(start, buffer.Length());
+			SetCaret(end, true);
+		}
 
-					while (size.x >= maxsize)
-					{
-						// trim characters ..
-						int diff = maxsize - size.x;
-						int amt = std::max(1, 2 * (diff / negsize.x));
-						displaytext = displaytext.substr(amt);
-						size = pge->GetTextSize(displaytext);
-						size = { (int)(size.x * cs.TextScale.x), (int)(size.y * cs.TextScale.y) };
-					}
-					olc::vi2d off = { cs.Padding.left,cs.Padding.top };
-					olc::vf2d textpos = UI::AlignTextIn(pge, displaytext, { { cs.Padding.left,cs.Padding.top },pos.Size }, cs.TextAlign, cs.TextScale);
-					pge->DrawString(textpos, displaytext, cs.ForegroundColor, cs.TextScale.x);
-					pge->FillRect({ off.x + size.x + 1, off.y + 2 }, { 2,pos.Size.y - 4 }, olc::Pixel(CursorColor.r, CursorColor.g, CursorColor.b, Alpha));
-				}
-			}
+		size_t SelectionStart() const { return std::min(caret, anchor); }
+		size_t SelectionEnd() const { return std::max(caret, anchor); }
+
+		/* GetSelectedText: the selected text, "" if nothing is selected */
+		std::string GetSelectedText() const { return buffer.Substr(SelectionStart(), SelectionEnd() - SelectionStart()); }
+
+		/* Insert: insert text at the caret, replacing any selection */
+		void Insert(const std::string& text)
+		{
+			deleteSelection();
+			insertAt(caret, text.c_str(), text.length());
+			caret = anchor = caret + text.length();
+			textChanged();
 		}
 
-		/* appendInput: check for any keys and append them to Text if there are any pressed that we care about, returns a bool indicating if any input caused Text to change */
-		bool appendInput(olc::PixelGameEngine* pge)
+		/* Append: add text to the end, without moving the caret.  Keeps following the end if it was in view, for logs. */
+		void Append(const std::string& text)
 		{
-			bool changed = false;
-			bool shifted = pge->GetKey(olc::SHIFT).bPressed || pge->GetKey(olc::SHIFT).bHeld;
-			std::string nstring = Text;
-			for (int i = 0; i < 41; i++)
+			bool following = TopLine + VisibleLines() >= lines.Count();
+			insertAt(buffer.Length(), text.c_str(), text.length());
+			if (following)
+				TopLine = lines.Count() > (size_t)VisibleLines() ? lines.Count() - VisibleLines() : 0;
+			textStale = true;
+			Invalidate();
+			if (OnTextChanged != NULL)
+				OnTextChanged(this);
+		}
+
+		/* TypeChar: edit the text as if a character was typed at the caret, 0x08 is backspace, 0x7f delete and '\n' a new line.  Returns true if Text changed */
+		bool TypeChar(char c)
+		{
+			if (c == 0x08 || c == 0x7f)
 			{
-				if (pge->GetKey(keyList[i]).bPressed)
+				if (!deleteSelection())
 				{
-					if (keyValues[i] == 0x08)
+					if (c == 0x08)
 					{
-						if (Text.length() > 0)
-						{
-							nstring = nstring.substr(0, nstring.length() - 1);
-							//SetText(Text.substr(0, Text.length() - 1));
-							changed = true;
-						}
+						if (caret == 0)
+							return false;
+						eraseAt(--caret, 1);
 					}
 					else
 					{
-						changed = true;
-						if (shifted)
-							nstring += keyValues[i];
-						else
-							nstring += keyValues[i + 41];
+						if (caret == buffer.Length())
+							return false;
+						eraseAt(caret, 1);
 					}
+					anchor = caret;
 				}
 			}
-			if (changed)
-				SetText(nstring);
-			return changed;
+			else
+			{
+				deleteSelection();
+				insertAt(caret++, &c, 1);
+				anchor = caret;
+			}
+			textChanged();
+			return true;
 		}
 
-		/* adjustFlasher: updates the pulse of the cursor */
-		void adjustFlasher(float fElapsedTime)
+	protected:
+		GapBuffer buffer;
+		LineIndex lines;
+		bool textStale = false;
+
+		/* caret, anchor: the caret and the other end of the selection.  column is the one the caret goes back to moving up and down. */
+		size_t caret = 0;
+		size_t anchor = 0;
+		size_t column = 0;
+
+		/* Alpha, Factor: the caret's pulse, as in TextEdit */
+		int Alpha = 0;
+		int Factor = 1;
+		bool focused = false;
+
+		int lineHeight(const ControlStyle& cs) { return 8 * std::max(1, (int)cs.TextScale.y); }
+
+		void insertAt(size_t pos, const char* text, size_t count)
+		{
+			buffer.Insert(pos, text, count);
+			lines.Inserted(pos, text, count);
+		}
+
+		void eraseAt(size_t pos, size_t count)
+		{
+			buffer.Erase(pos, count);
+			lines.Erased(pos, count);
+		}
+
+		bool deleteSelection()
+		{
+			if (caret == anchor)
+				return false;
+			size_t start = SelectionStart();
+			eraseAt(start, SelectionEnd() - start);
+			caret = anchor = start;
+			return true;
+		}
+
+		void textChanged()
+		{
+			textStale = true;
+			column = caret - lines.Start(lines.LineOf(caret));
+			scrollToCaret();
+			Invalidate();
+			if (OnTextChanged != NULL)
+				OnTextChanged(this);
+		}
+
+		/* scrollToCaret: scroll as little as possible to have the caret's line in view */
+		void scrollToCaret()
+		{
+			size_t line = lines.LineOf(caret);
+			size_t visible = (size_t)VisibleLines();
+			if (line < TopLine)
+				TopLine = line;
+			else if (line >= TopLine + visible)
+				TopLine = line - visible + 1;
+		}
+
+		/* moveLines: move the caret up or down lines, keeping to its column */
+		void moveLines(int amt, bool select)
+		{
+			long long line = (long long)lines.LineOf(caret) + amt;
+			line = std::max(0LL, std::min(line, (long long)lines.Count() - 1));
+			size_t start = lines.Start((size_t)line);
+			size_t keep = column;
+			SetCaret(std::min(start + keep, lines.End((size_t)line)), select);
+			column = keep;
+		}
+
+		void Update(float fElapsedTime) override
 		{
 			int cur_alpha = Alpha;
-			int amt = (int)(Pace * fElapsedTime);
-			int a = Alpha + (amt * Factor);
-			if (a > 255)
-			{
-				a = 255;
-				Factor *= -1;
-			}
-			else if (a < 0)
+			int a = Alpha + ((int)(900 * fElapsedTime) * Factor);
+			if (a > 255 || a < 0)
 			{
-				a = 0;
+				a = std::max(0, std::min(a, 255));
 				Factor *= -1;
 			}
 			Alpha = a;
-			if (cur_alpha != a)
-				Invalidate();
+			if (cur_alpha != a && focused)
+				InvalidateOverlay();
 		}
 
-		/* Focus: overridden to handle focus */
 		void Focus() override
 		{
 			focused = true;
-			Invalidate();
+			InvalidateOverlay();
+			ControlBase::Focus();
 		}
 
-		/* Blur: overridden to handle focus */
 		void Blur() override
 		{
 			focused = false;
-			Invalidate();
+			InvalidateOverlay();
+			ControlBase::Blur();
+		}
+
+		/* HandleFocusInput: typing, Enter, Delete, and the arrow keys, Home, End, Page Up and Page Down with shift to select */
+		void HandleFocusInput(const InputState& input, float fElapsedTime) override
+		{
+			bool shifted = input.Shifted();
+			if (!ReadOnly)
+			{
+				for (char c : UI::TypedKeys(input))
+					TypeChar(c);
+				if (input.Key(olc::Key::ENTER).bPressed || input.Key(olc::Key::RETURN).bPressed)
+					TypeChar('\n');
+				if (input.Key(olc::Key::DEL).bPressed)
+					TypeChar(0x7f);
+			}
+			if (input.Key(olc::Key::LEFT).bPressed)
+				SetCaret(caret > 0 ? caret - 1 : 0, shifted);
+			if (input.Key(olc::Key::RIGHT).bPressed)
+				SetCaret(caret + 1, shifted);
+			if (input.Key(olc::Key::UP).bPressed)
+				moveLines(-1, shifted);
+			if (input.Key(olc::Key::DOWN).bPressed)
+				moveLines(1, shifted);
+			if (input.Key(olc::Key::PGUP).bPressed)
+				moveLines(-VisibleLines(), shifted);
+			if (input.Key(olc::Key::PGDN).bPressed)
+				moveLines(VisibleLines(), shifted);
+			if (input.Key(olc::Key::HOME).bPressed)
+				SetCaret(lines.Start(lines.LineOf(caret)), shifted);
+			if (input.Key(olc::Key::END).bPressed)
+				SetCaret(lines.End(lines.LineOf(caret)), shifted);
+		}
+
+		/* MouseDown: put the caret under the mouse */
+		void MouseDown(int mButton) override
+		{
+			ControlBase::MouseDown(mButton);
+			const ControlStyle& cs = Theme->GetStyle(Enabled, Hovering, Active);
+			int scale = std::max(1, (int)cs.TextScale.x);
+			olc::vi2d local = UI::MousePos - GetClientRect().Position;
+			size_t line = std::min(TopLine + (size_t)std::max(0, local.y / lineHeight(cs)), lines.Count() - 1);
+			size_t pos = lines.Start(line);
+			size_t end = lines.End(line);
+			for (int width = 0; pos < end; pos++)
+			{
+				int advance = TextLayout::Advance(buffer.At(pos));
+				if ((width + advance / 2) * scale > local.x)
+					break;
+				width += advance;
+			}
+			SetCaret(pos);
+		}
+
+		/* DrawText: draw the lines in view */
+		void DrawText(RenderBackend* rb, float fElapsedTime) override
+		{
+			Rect pos = GetClientRect();
+			const ControlStyle& cs = Theme->GetStyle(Enabled, Hovering, Active);
+			int scale = std::max(1, (int)cs.TextScale.x);
+			int height = lineHeight(cs);
+			int room = pos.Size.x / scale;
+			olc::vi2d off = { cs.Padding.left, cs.Padding.top };
+
+			size_t last = std::min(lines.Count(), TopLine + (size_t)(pos.Size.y / height) + 1);
+			std::string shown;
+			for (size_t line = TopLine; line < last; line++)
+			{
+				size_t start = lines.Start(line);
+				size_t end = lines.End(line);
+				olc::vi2d at = { off.x, off.y + (int)(line - TopLine) * height };
+
+				// only the characters that fit
+				shown.clear();
+				int width = 0;
+				for (size_t i = start; i < end && width < room; i++)
+				{
+					char c = buffer.At(i);
+					shown += c;
+					width += TextLayout::Advance(c);
+				}
+				if (shown.length() > 0)
+					rb->DrawTextLayout(at, *rb->LayoutText(shown), cs.ForegroundColor, (uint32_t)scale);
+			}
+		}
+
+		/* DrawOverlay: the selection and the caret on the lines in view, so neither redraws the canvas as they change */
+		void DrawOverlay(RenderBackend* rb, float fElapsedTime, Rect clip) override
+		{
+			size_t selStart = SelectionStart();
+			size_t selEnd = SelectionEnd();
+			if (!focused && selEnd == selStart)
+				return;
+			const ControlStyle& cs = Theme->GetStyle(Enabled, Hovering, Active);
+			int scale = std::max(1, (int)cs.TextScale.x);
+			int height = lineHeight(cs);
+			Rect pos = GetClientRect();
+			int room = pos.Size.x / scale;
+
+			size_t last = std::min(lines.Count(), TopLine + (size_t)(pos.Size.y / height) + 1);
+			for (size_t line = TopLine; line < last; line++)
+			{
+				size_t start = lines.Start(line);
+				size_t end = lines.End(line);
+				bool selected = selEnd > start && selStart <= end && selEnd > selStart;
+				bool hasCaret = focused && caret >= start && caret <= end;
+				if (!selected && !hasCaret)
+					continue;
+				olc::vi2d at = { pos.Position.x, pos.Position.y + (int)(line - TopLine) * height };
+				// the x of a character on this line, as DrawText laid it out
+				auto charX = [&](size_t index)
+				{
+					int width = 0;
+					for (size_t i = start; i < index && width < room; i++)
+						width += TextLayout::Advance(buffer.At(i));
+					return at.x + width * scale;
+				};
+
+				if (selected)
+				{
+					int x0 = charX(std::max(selStart, start));
+					int x1 = selEnd > end ? charX(end) + 4 * scale : charX(selEnd); // a bit past the end for a selected line break
+					overlayQuad(rb, clip, { x0, at.y }, { x1 - x0, height }, SelectionColor);
+				}
+				if (hasCaret)
+					overlayQuad(rb, clip, { charX(caret), at.y }, { 2, height }, olc::Pixel(CursorColor.r, CursorColor.g, CursorColor.b, Alpha));
+			}
 		}
 	};
 
@@ -1490,7 +6817,7 @@ namespace RasputinUI
 			{
 				value = val;
 				SetPosition();
-				OnValue.Invoke(this, value);
+				raise(RaisedValue);
 			}
 		}
 
@@ -1509,15 +6836,17 @@ namespace RasputinUI
 
 		EventHandler1Param<int> OnValue;
 
+		const char* TypeName() const override { return "Slider"; }
+
 		Slider(Rect location, ControlBase* parent, int min, int max, int current, olc::PixelGameEngine* pge)
 			: ControlBase(location, parent)
 		{
-			Theme.Default.BorderType = RUI::BorderType::Sunken;
+			Theme.Edit().Default.BorderType = RUI::BorderType::Sunken;
 			minimum = min;
 			maximum = max;
 			value = current;
 			track = new ControlBase({ {2,2}, {location.Size.y - 4,location.Size.y - 4 } }, this);
-			track->Theme.Default.BorderType = RUI::BorderType::Raised;
+			track->Theme.Edit().Default.BorderType = RUI::BorderType::Raised;
 
 			dragger = new DragHandle({ {0,0},track->Size() }, track, pge);
 			dragger->DragControl = track;
@@ -1529,6 +6858,14 @@ namespace RasputinUI
 			});
 		}
 
+	protected:
+		void dispatchEvents(uint32_t events) override
+		{
+			ControlBase::dispatchEvents(events);
+			if (events & RaisedValue)
+				OnValue.Invoke(this, value);
+		}
+
 	private:
 		ControlBase* track;
 		DragHandle* dragger;
@@ -1571,7 +6908,7 @@ namespace RasputinUI
 				if (nvalue != value)
 				{
 					value = nvalue;
-					OnValue.Invoke(this, value);
+					raise(RaisedValue);
 				}
 			}
 			else
@@ -1585,7 +6922,7 @@ namespace RasputinUI
 				if (nvalue != value)
 				{
 					value = nvalue;
-					OnValue.Invoke(this, value);
+					raise(RaisedValue);
 				}
 			}
 		}
@@ -0,0 +1,175 @@
+/*
+Tests: headless checks of behaviour that is easy to break, run against a RecordingBackend with no window or GL context.
+
+Usage: Tests
+Prints each failed check, and returns the number of them.
+*/
+#define OLC_PGE_APPLICATION
+
+#include "RasputinUI.h"
+#include <cstdio>
+
+using namespace RasputinUI;
+
+static int failures = 0;
+
+#define CHECK(condition) do { if (!(condition)) { printf("%s:%d: %s failed\n", __func__, __LINE__, #condition); failures++; } } while (0)
+
+/* Scene: a headless UIManager */
+struct Scene
+{
+	RecordingBackend backend;
+	UIManager ui;
+	InputState input;
+
+	Scene() : backend(olc::vi2d(640, 480)), ui(&backend) {}
+
+	ControlBase* root() { return ui.mainControl; }
+
+	void Frame(int frames = 1)
+	{
+		for (int i = 0; i < frames; i++)
+		{
+			input.BeginFrame(0.016f);
+			ui.Update(0.016f, input);
+		}
+	}
+};
+
+/* inZOrder: whether a control's children are bottom first */
+static bool inZOrder(ControlBase* control)
+{
+	uint32_t last = 0;
+	bool first = true;
+	for (auto child : control->Controls)
+	{
+		if (!first && child->ZIndex < last)
+			return false;
+		last = child->ZIndex;
+		first = false;
+	}
+	return true;
+}
+
+/* Spawner: adds siblings and raises one from its Update, while the UIManager is looping over its siblings */
+class Spawner : public ControlBase
+{
+public:
+	ControlBase* ToRaise = NULL;
+	int Added = 0;
+
+	Spawner(Rect location, ControlBase* parent) : ControlBase(location, parent) {}
+
+	void Update(float fElapsedTime) override
+	{
+		if (Added > 0)
+			return;
+		for (; Added < 64; Added++) // enough to grow the array under the loop
+			new ControlBase({ { Added * 4, 100 }, { 8,8 } }, Parent);
+		ToRaise->PopToTop();
+	}
+};
+
+void TestChildrenChangedDuringUpdate()
+{
+	Scene scene;
+	ControlBase* bottom = new ControlBase({ { 10,10 }, { 50,50 } }, scene.root());
+	Spawner* spawner = new Spawner({ { 20,20 }, { 50,50 } }, scene.root());
+	ControlBase* top = new ControlBase({ { 30,30 }, { 50,50 } }, scene.root());
+	spawner->ToRaise = bottom;
+
+	scene.Frame();
+	CHECK(spawner->Added == 64);
+	CHECK(scene.root()->Controls.size() == 3 + 64);
+	CHECK(inZOrder(scene.root()));
+	CHECK(scene.root()->Controls.back() == bottom);
+
+	// the raised control is now hit first where it overlaps the others
+	scene.input.MousePos = { 35,35 };
+	scene.Frame();
+	CHECK(scene.root()->MouseOver({ 35,35 }) == bottom);
+
+	top->PopToTop();
+	scene.Frame();
+	CHECK(inZOrder(scene.root()));
+	CHECK(scene.root()->Controls.back() == top);
+}
+
+/* topRowText: the text of the row at the top of a list */
+static std::string topRowText(ListControl* list)
+{
+	ControlBase* top = NULL;
+	for (auto row : list->Controls)
+		if (top == NULL || row->Position().y < top->Position().y)
+			top = row;
+	return top == NULL ? "" : top->GetText();
+}
+
+void TestFilteredListKeepsScrollPosition()
+{
+	Scene scene;
+	ListControl* list = new ListControl({ { 10,10 }, { 200,200 } }, scene.root());
+	std::vector<std::string> items;
+	for (int i = 0; i < 200; i++)
+		items.push_back("Item " + std::to_string(i));
+	list->SetItems(items);
+	list->SetFilter("1");
+	list->WaitForIndex();
+	scene.Frame();
+	list->ScrollTo(150);
+	list->ScrollTo(110);
+	scene.Frame();
+	int top = list->GetTopIndex();
+	CHECK(top > 0);
+	CHECK(topRowText(list) == "Item 110");
+
+	// items above the view, passing the filter and not, move the top row but not what it shows
+	list->InsertItems(0, { "new 1", "new 2", "new 10" });
+	scene.Frame();
+	CHECK(list->GetTopIndex() == top + 2);
+	CHECK(topRowText(list) == "Item 110");
+
+	list->RemoveRange(0, 3);
+	scene.Frame();
+	CHECK(list->GetTopIndex() == top);
+	CHECK(topRowText(list) == "Item 110");
+
+	// the top item going away shows the next one that passes
+	list->RemoveRange(105, 6);
+	scene.Frame();
+	CHECK(topRowText(list) == "Item 111");
+
+	// inserting a batch above the view refreshes every row it moved
+	list->BeginUpdate();
+	list->UpdateItem(0, "Item 0");
+	list->InsertItems(1, { "new 1" });
+	list->EndUpdate();
+	scene.Frame();
+	CHECK(topRowText(list) == "Item 111");
+}
+
+void TestAnimatedBackgroundWithoutSheet()
+{
+	AnimatedSpriteBackground none(NULL, { 0,0 }, 12.0f); // outlives the controls showing it
+	Scene scene;
+	CHECK(none.FrameCount == 1);
+	ControlBase* control = new ControlBase({ { 10,10 }, { 50,50 } }, scene.root());
+	control->Theme.Edit().Default.Background = &none;
+	for (int i = 0; i < 10; i++)
+	{
+		scene.Frame();
+		scene.ui.Render(0.1f);
+	}
+	CHECK(none.GetFrame() == 0);
+}
+
+int main()
+{
+	TestChildrenChangedDuringUpdate();
+	TestFilteredListKeepsScrollPosition();
+	TestAnimatedBackgroundWithoutSheet();
+
+	if (failures == 0)
+		printf("all passed\n");
+	return failures;
+}